@@ -1,15 +1,25 @@
 #include <iostream>
 #include <iomanip>
+#include <fstream>
 #include <filesystem>
+#include <functional>
+#include <memory>
 #include <algorithm>
-#include <numeric>
 #include <vector>
 #include <string>
+#include <limits>
 #include "include/cxxopts.hpp"
 #include "include/config/Config.h"
 #include "include/utils/FileUtils.h"
+#include "include/utils/BufferPool.h"
 #include "include/clip/CLIPInference.h"
 #include "include/math/Similarity.h"
+#include "include/pipeline/ImagePipeline.h"
+#include "include/pipeline/ImageListReader.h"
+#include "include/pipeline/TarShardReader.h"
+#include "include/store/EmbeddingStore.h"
+#include "include/store/IndexManifest.h"
+#include "include/ann/HnswIndex.h"
 
 int main(int argc, char* argv[]) {
     try {
@@ -18,24 +28,71 @@ int main(int argc, char* argv[]) {
 
         options.add_options()
             ("i,images", "Path to images directory", cxxopts::value<std::string>())
+            ("shards", "Read images from tar shards instead: a .tar file or a directory of them", cxxopts::value<std::string>())
+            ("image-list", "Read image paths from this file, one per line, instead of --images; '-' reads stdin", cxxopts::value<std::string>())
             ("d,models-dir", "Path to models directory (required)", cxxopts::value<std::string>())
             ("k,topk", "Number of top matches to show", cxxopts::value<int>())
             ("m,max-images", "Maximum number of images to process", cxxopts::value<int>())
+            ("sniff-images", "Also index files without an image extension that start with an image signature")
+            ("scan-threads", "Number of threads listing subdirectories while looking for images", cxxopts::value<int>())
+            ("decode-threads", "Number of image decode threads (0 = all cores)", cxxopts::value<int>())
+            ("inference-threads", "Number of concurrent image encoder runs", cxxopts::value<int>())
+            ("batch-size", "Images per encoder call (model must support dynamic batch)", cxxopts::value<int>())
+            ("queue-depth", "Max preprocessed batches waiting for inference", cxxopts::value<int>())
+            ("prefetch-threads", "Threads reading image files ahead of the decoders (0 = off)", cxxopts::value<int>())
+            ("prefetch-mb", "Max megabytes of image files read ahead and not yet decoded", cxxopts::value<int>())
+            ("tiles", "Encode each image as global view + NxN overlapping tiles and rank by pooled embedding", cxxopts::value<int>())
+            ("tile-overlap", "Fraction of tile size shared by neighbouring tiles", cxxopts::value<float>())
+            ("similarity-threads", "Number of threads for similarity and top-K search (0 = all cores)", cxxopts::value<int>())
+            ("text-cache", "Keep text embeddings in this file across runs, only new prompts are encoded", cxxopts::value<std::string>())
+            ("image-cache", "Keep image embeddings in this file keyed by file content, seen images are not re-encoded", cxxopts::value<std::string>())
+            ("index-store", "Incrementally index the whole images directory into this store file; only new or changed images are encoded", cxxopts::value<std::string>())
+            ("save-embeddings", "Write image embeddings to a memory-mappable store file", cxxopts::value<std::string>())
+            ("save-index", "Build an HNSW index over image embeddings and write it to file", cxxopts::value<std::string>())
             ("h,help", "Print help");
 
         auto result = options.parse(argc, argv);
 
-        if (result.count("help") || !result.count("images") || !result.count("models-dir")) {
+        bool shardMode = result.count("shards") > 0;
+        bool listMode = result.count("image-list") > 0;
+        // Images come from a pipeline::ImageSource as they are read instead of a directory listed up front
+        bool streamMode = shardMode || listMode;
+        if (result.count("help") || (!result.count("images") && !streamMode) || !result.count("models-dir")) {
             std::cout << options.help() << std::endl;
             return 0;
         }
+        if (shardMode && listMode) {
+            throw std::runtime_error("--shards and --image-list cannot be combined");
+        }
+        if (streamMode && (result.count("tiles") || result.count("index-store"))) {
+            throw std::runtime_error("--shards and --image-list cannot be combined with --tiles or --index-store");
+        }
 
-        std::filesystem::path imagesDir = result["images"].as<std::string>();
+        std::filesystem::path imagesDir = streamMode ? std::filesystem::path() : std::filesystem::path(result["images"].as<std::string>());
         std::filesystem::path modelsDir = result["models-dir"].as<std::string>();
         
         int topK = result.count("topk") > 0 ? result["topk"].as<int>() : config::DEFAULT_TOP_K;
         
         int maxImages = result.count("max-images") > 0 ? result["max-images"].as<int>() : config::DEFAULT_MAX_IMAGES;
+        int scanThreads = result.count("scan-threads") > 0 ? result["scan-threads"].as<int>() : config::DEFAULT_SCAN_THREADS;
+        bool sniffImages = result.count("sniff-images") > 0;
+
+        pipeline::PipelineOptions pipelineOptions;
+        pipelineOptions.decodeThreads = result.count("decode-threads") > 0 ? result["decode-threads"].as<int>() : config::DEFAULT_DECODE_THREADS;
+        pipelineOptions.inferenceThreads = result.count("inference-threads") > 0 ? result["inference-threads"].as<int>() : config::DEFAULT_INFERENCE_THREADS;
+        pipelineOptions.batchSize = result.count("batch-size") > 0 ? result["batch-size"].as<int>() : config::DEFAULT_BATCH_SIZE;
+        pipelineOptions.queueDepth = result.count("queue-depth") > 0 ? result["queue-depth"].as<int>() : config::DEFAULT_QUEUE_DEPTH;
+        pipelineOptions.prefetchThreads = result.count("prefetch-threads") > 0 ? result["prefetch-threads"].as<int>() : config::DEFAULT_PREFETCH_THREADS;
+        int prefetchMb = result.count("prefetch-mb") > 0 ? result["prefetch-mb"].as<int>() : config::DEFAULT_PREFETCH_MB;
+        pipelineOptions.prefetchBytes = static_cast<size_t>(std::max(prefetchMb, 1)) << 20;
+
+        int similarityThreads = result.count("similarity-threads") > 0 ? result["similarity-threads"].as<int>() : config::DEFAULT_SIMILARITY_THREADS;
+        math::setThreadCount(static_cast<size_t>(std::max(similarityThreads, 0)));
+
+        bool tiled = result.count("tiles") > 0;
+        image::TileOptions tileOptions;
+        tileOptions.grid = tiled ? result["tiles"].as<int>() : config::DEFAULT_TILE_GRID;
+        tileOptions.overlap = result.count("tile-overlap") > 0 ? result["tile-overlap"].as<float>() : config::DEFAULT_TILE_OVERLAP;
 
         // Load text classes
         // Try to find classes.txt relative to models directory or executable
@@ -53,62 +110,239 @@ int main(int argc, char* argv[]) {
         std::vector<std::string> texts = utils::loadTextClasses(classesTxt);
         std::cout << "Loaded " << texts.size() << " text classes from " << classesTxt.filename().string() << "." << std::endl;
 
+        // Incremental mode: previous store and manifest, the whole directory is compared against them
+        bool incremental = result.count("index-store") > 0;
+        std::filesystem::path indexStorePath;
+        store::EmbeddingStore imageStore(config::EMBEDDING_DIM);
+        store::IndexManifest manifest;
+        if (incremental) {
+            indexStorePath = result["index-store"].as<std::string>();
+            if (std::filesystem::exists(indexStorePath)) {
+                imageStore = store::EmbeddingStore::load(indexStorePath);
+            }
+            manifest = store::IndexManifest::load(store::IndexManifest::pathFor(indexStorePath));
+
+            // Rows of a missing, replaced or half-saved store cannot be trusted, start over
+            if (imageStore.dim() != config::EMBEDDING_DIM || !manifest.matches(imageStore)) {
+                std::cout << "Index manifest does not match " << indexStorePath.string() << ", reindexing all images" << std::endl;
+                imageStore = store::EmbeddingStore(config::EMBEDDING_DIM);
+                manifest = store::IndexManifest();
+            }
+        }
+
         // Load images
-        std::vector<std::filesystem::path> imagePaths = utils::loadTestImages(imagesDir, maxImages);
-        std::cout << "Found " << imagePaths.size() << " images (limit: " << maxImages << "):" << std::endl;
-        for (const auto& path : imagePaths) {
-            std::cout << "  " << std::filesystem::relative(path, imagesDir).string() << std::endl;
+        std::vector<std::filesystem::path> imagePaths;
+        std::vector<std::filesystem::path> shardPaths;
+        if (shardMode) {
+            shardPaths = pipeline::findTarShards(result["shards"].as<std::string>());
+            std::cout << "Found " << shardPaths.size() << " tar shards (image limit: " << maxImages << ")" << std::endl;
+        } else if (listMode) {
+            std::cout << "Reading image paths from " << result["image-list"].as<std::string>() << " (image limit: " << maxImages << ")" << std::endl;
+        } else if (incremental) {
+            std::vector<std::filesystem::path> allPaths = utils::loadTestImages(imagesDir, std::numeric_limits<int>::max(), scanThreads, sniffImages);
+            store::ManifestUpdate update = manifest.scan(imagesDir, allPaths);
+            imagePaths = std::move(update.changed);
+            std::cout << "Found " << allPaths.size() << " images: " << update.unchanged << " unchanged, "
+                      << imagePaths.size() << " new or changed, " << update.deleted << " deleted" << std::endl;
+        } else {
+            imagePaths = utils::loadTestImages(imagesDir, maxImages, scanThreads, sniffImages);
+            std::cout << "Found " << imagePaths.size() << " images (limit: " << maxImages << "):" << std::endl;
+            for (const auto& path : imagePaths) {
+                std::cout << "  " << std::filesystem::relative(path, imagesDir).string() << std::endl;
+            }
         }
 
         // Initialize CLIP
         std::cout << "\n=== Loading ONNX models ===" << std::endl;
-        clip::CLIPInference clip(modelsDir);
+        // Unit-length embeddings: similarity below is a plain dot product
+        clip::CLIPInference clip(modelsDir, true);
         std::cout << "Models loaded successfully!" << std::endl;
 
+        if (result.count("text-cache")) {
+            clip.setTextCache(result["text-cache"].as<std::string>());
+        }
+        if (result.count("image-cache")) {
+            clip.setImageCache(result["image-cache"].as<std::string>());
+        }
+
         // Encode texts (with caching)
         std::cout << "\n=== Encoding text classes ===" << std::endl;
-        std::vector<std::vector<float>> textEmbeddings = clip.encodeTexts(texts);
-        std::cout << "Encoded " << textEmbeddings.size() << " text classes." << std::endl;
+        math::MatrixView textEmbeddings = clip.encodeTexts(texts);
+        std::cout << "Encoded " << textEmbeddings.rows << " text classes." << std::endl;
 
         // Encode images
         std::cout << "\n=== Encoding images ===" << std::endl;
-        std::vector<std::vector<float>> imageEmbeddings;
-        imageEmbeddings.reserve(imagePaths.size());
-
-        for (size_t i = 0; i < imagePaths.size(); ++i) {
-            try {
-                std::vector<float> embedding = clip.encodeImage(imagePaths[i]);
-                imageEmbeddings.push_back(embedding);
-                std::cout << "Encoded image " << (i + 1) << "/" << imagePaths.size() << std::endl;
-            } catch (const std::exception& e) {
-                std::cerr << "Error encoding image " << imagePaths[i] << ": " << e.what() << std::endl;
-                // Add zero embedding as placeholder
-                imageEmbeddings.push_back(std::vector<float>(config::EMBEDDING_DIM, 0.0f));
+        // Failed images keep a zero embedding as placeholder
+        std::vector<std::vector<float>> imageEmbeddings(imagePaths.size(), std::vector<float>(config::EMBEDDING_DIM, 0.0f));
+        std::vector<char> imageEncoded(imagePaths.size(), 0);
+        std::vector<std::string> imageIds;
+        size_t encodedCount = 0;
+
+        if (streamMode) {
+            // Images are numbered as they are read, so the per-image vectors grow with the results
+            const size_t limit = maxImages < 0 ? std::numeric_limits<size_t>::max() : static_cast<size_t>(maxImages);
+            std::unique_ptr<pipeline::ImageSource> source;
+            std::function<std::string(size_t)> sourceKey;
+            std::ifstream listFile;
+            if (shardMode) {
+                pipeline::TarShardOptions shardOptions;
+                shardOptions.threads = std::max(1, pipelineOptions.prefetchThreads);
+                shardOptions.maxBytesInFlight = pipelineOptions.prefetchBytes;
+                shardOptions.limit = limit;
+                shardOptions.sniffContent = sniffImages;
+                auto shardReader = std::make_unique<pipeline::TarShardReader>(shardPaths, shardOptions);
+                sourceKey = [reader = shardReader.get()](size_t index) { return reader->key(index); };
+                source = std::move(shardReader);
+            } else {
+                std::string listPath = result["image-list"].as<std::string>();
+                if (listPath != "-") {
+                    listFile.open(listPath);
+                    if (!listFile.is_open()) {
+                        throw std::runtime_error("Failed to open image list: " + listPath);
+                    }
+                }
+                auto listReader = std::make_unique<pipeline::ImageListReader>(listPath == "-" ? std::cin : listFile, limit);
+                sourceKey = [reader = listReader.get()](size_t index) { return reader->path(index); };
+                source = std::move(listReader);
+            }
+
+            auto slot = [&](size_t index) {
+                if (index >= imageIds.size()) {
+                    imageIds.resize(index + 1);
+                    imageEmbeddings.resize(index + 1);
+                    imageEncoded.resize(index + 1, 0);
+                }
+                imageIds[index] = sourceKey(index);
+            };
+
+            pipeline::ImagePipeline imagePipeline(clip, pipelineOptions);
+            imagePipeline.run(*source,
+                [&](size_t index, std::vector<float>&& embedding) {
+                    slot(index);
+                    imageEmbeddings[index] = std::move(embedding);
+                    imageEncoded[index] = 1;
+                    std::cout << "Encoded image " << ++encodedCount << ": " << imageIds[index] << std::endl;
+                },
+                [&](size_t index, const std::string& message) {
+                    slot(index);
+                    std::cerr << "Error encoding image " << imageIds[index] << ": " << message << std::endl;
+                });
+        } else if (tiled) {
+            // Every image is already a batch of global view + tiles
+            for (size_t i = 0; i < imagePaths.size(); ++i) {
+                try {
+                    clip::TiledEmbedding tiledEmbedding = clip.encodeImageTiled(imagePaths[i], tileOptions);
+                    imageEmbeddings[i] = std::move(tiledEmbedding.pooled);
+                    imageEncoded[i] = 1;
+                    std::cout << "Encoded image " << ++encodedCount << "/" << imagePaths.size()
+                              << " (" << tiledEmbedding.tiles.size() << " tiles)" << std::endl;
+                } catch (const std::exception& e) {
+                    std::cerr << "Error encoding image " << imagePaths[i] << ": " << e.what() << std::endl;
+                }
+            }
+        } else {
+            pipeline::ImagePipeline imagePipeline(clip, pipelineOptions);
+            imagePipeline.run(imagePaths,
+                [&](size_t index, std::vector<float>&& embedding) {
+                    imageEmbeddings[index] = std::move(embedding);
+                    imageEncoded[index] = 1;
+                    std::cout << "Encoded image " << ++encodedCount << "/" << imagePaths.size() << std::endl;
+                },
+                [&](size_t index, const std::string& message) {
+                    std::cerr << "Error encoding image " << imagePaths[index] << ": " << message << std::endl;
+                });
+        }
+
+        utils::BufferPoolStats poolStats = utils::floatBufferPool().stats();
+        std::cout << "Tensor buffer pool: " << poolStats.hits << "/" << poolStats.acquisitions << " hits, peak in use "
+                  << (poolStats.peakBytesInUse >> 10) << " KB, peak cached " << (poolStats.peakCachedBytes >> 10) << " KB" << std::endl;
+
+        // Collect image embeddings into one contiguous store keyed by relative path
+        std::vector<size_t> rankedRows;
+        if (incremental) {
+            // Failed images are not committed, so the next run retries them
+            for (size_t i = 0; i < imagePaths.size(); ++i) {
+                if (imageEncoded[i]) {
+                    size_t row = imageStore.add(store::IndexManifest::key(imagesDir, imagePaths[i]), imageEmbeddings[i]);
+                    manifest.commit(imagesDir, imagePaths[i], row);
+                }
+            }
+
+            // Rows of changed and deleted images stay in the store until they outnumber the live ones
+            // An HNSW index numbers its nodes by store row, so it needs a store without dead rows
+            std::vector<uint64_t> liveRows = manifest.liveRows();
+            const bool needsCompactStore = result.count("save-index") > 0 && imageStore.size() != liveRows.size();
+            if (imageStore.size() > 2 * liveRows.size() || needsCompactStore) {
+                store::EmbeddingStore compacted(imageStore.dim());
+                for (uint64_t row : liveRows) {
+                    compacted.add(imageStore.id(row), imageStore.row(row), imageStore.dim(), imageStore.metadata(row));
+                }
+                std::cout << "Compacted store: dropped " << imageStore.size() - compacted.size() << " dead rows" << std::endl;
+                imageStore = std::move(compacted);
+                manifest.compact();
+                liveRows = manifest.liveRows();
+            }
+
+            imageStore.save(indexStorePath);
+            manifest.save(store::IndexManifest::pathFor(indexStorePath));
+            std::cout << "Index " << indexStorePath.string() << ": " << liveRows.size() << " images, "
+                      << imageStore.size() - liveRows.size() << " dead rows" << std::endl;
+            rankedRows.assign(liveRows.begin(), liveRows.end());
+        } else if (streamMode) {
+            // Keyed by shard/member or listed path; images that failed to decode are left out
+            for (size_t i = 0; i < imageIds.size(); ++i) {
+                if (imageEncoded[i]) {
+                    rankedRows.push_back(imageStore.add(imageIds[i], imageEmbeddings[i]));
+                }
+            }
+        } else {
+            for (size_t i = 0; i < imagePaths.size(); ++i) {
+                rankedRows.push_back(imageStore.add(std::filesystem::relative(imagePaths[i], imagesDir).generic_string(), imageEmbeddings[i]));
             }
         }
+        imageEmbeddings.clear();
 
-        // Compute cosine similarity
+        if (result.count("save-embeddings")) {
+            std::filesystem::path storePath = result["save-embeddings"].as<std::string>();
+            imageStore.save(storePath);
+            std::cout << "Saved " << imageStore.size() << " image embeddings to " << storePath.string() << std::endl;
+        }
+
+        if (result.count("save-index")) {
+            // Index rows follow store rows, so search results map back through imageStore.id()
+            std::filesystem::path indexPath = result["save-index"].as<std::string>();
+            ann::HnswIndex index(imageStore.dim());
+            index.build(imageStore.vectors());
+            index.save(indexPath);
+            std::cout << "Saved HNSW index over " << index.size() << " images to " << indexPath.string() << std::endl;
+        }
+
+        // Compute cosine similarity fused with top-K selection
+        // Dead rows of an incremental store are skipped by gathering the live ones
         std::cout << "\n=== Computing cosine similarity ===" << std::endl;
-        std::vector<std::vector<float>> similarityMatrix = math::cosineSimilarityMatrix(imageEmbeddings, textEmbeddings);
+        math::Matrix liveImages;
+        math::MatrixView rankedImages = imageStore.vectors();
+        if (rankedRows.size() != imageStore.size()) {
+            liveImages = math::Matrix(rankedRows.size(), imageStore.dim());
+            for (size_t i = 0; i < rankedRows.size(); ++i) {
+                std::copy_n(imageStore.row(rankedRows[i]), imageStore.dim(), liveImages.row(i));
+            }
+            rankedImages = liveImages.view();
+        }
+        math::TopK matches = math::topKDotProduct(
+            rankedImages, textEmbeddings,
+            static_cast<size_t>(std::max(topK, 0)));
 
         // Print top-K results
         std::cout << "\n=== Top-" << topK << " text descriptions for each image ===" << std::endl;
 
-        for (size_t i = 0; i < imagePaths.size(); ++i) {
-            const auto& scores = similarityMatrix[i];
-            
-            // Create indices and sort by score
-            std::vector<size_t> indices(scores.size());
-            std::iota(indices.begin(), indices.end(), 0);
-            std::sort(indices.begin(), indices.end(), [&scores](size_t a, size_t b) {
-                return scores[a] > scores[b];
-            });
-
-            std::cout << "\nImage: " << std::filesystem::relative(imagePaths[i], imagesDir).string() << std::endl;
-            for (int rank = 0; rank < topK && rank < static_cast<int>(indices.size()); ++rank) {
-                size_t idx = indices[rank];
+        for (size_t i = 0; i < rankedRows.size(); ++i) {
+            const math::ScoredIndex* best = matches.row(i);
+
+            std::cout << "\nImage: " << imageStore.id(rankedRows[i]) << std::endl;
+            for (size_t rank = 0; rank < matches.k; ++rank) {
                 std::cout << "  " << (rank + 1) << ". score=" << std::fixed << std::setprecision(4) 
-                          << scores[idx] << " | " << texts[idx] << std::endl;
+                          << best[rank].score << " | " << texts[best[rank].index] << std::endl;
             }
         }
 
@@ -0,0 +1,43 @@
+// Shared fixtures of the standalone ANN / quantization benchmarks
+#pragma once
+
+#include <random>
+#include "math/Matrix.h"
+#include "math/Similarity.h"
+
+namespace bench {
+
+    // Unit vectors scattered around random cluster centers, closer to real embeddings than uniform noise
+    inline math::Matrix clusteredMatrix(const math::Matrix& centers, size_t rows, float spread, std::mt19937& rng) {
+        std::uniform_int_distribution<size_t> pickCenter(0, centers.rows() - 1);
+        std::normal_distribution<float> noise(0.0f, spread);
+
+        math::Matrix m(rows, centers.cols());
+        for (size_t i = 0; i < rows; ++i) {
+            const float* center = centers.row(pickCenter(rng));
+            for (size_t j = 0; j < m.cols(); ++j) {
+                m(i, j) = center[j] + noise(rng);
+            }
+        }
+        math::normalizeRows(m);
+        return m;
+    }
+
+    inline double recallAtK(const math::TopK& exact, const math::TopK& approx) {
+        size_t found = 0;
+        for (size_t i = 0; i < exact.rows; ++i) {
+            const math::ScoredIndex* truth = exact.row(i);
+            const math::ScoredIndex* result = approx.row(i);
+            for (size_t a = 0; a < approx.k; ++a) {
+                for (size_t t = 0; t < exact.k; ++t) {
+                    if (result[a].index == truth[t].index) {
+                        ++found;
+                        break;
+                    }
+                }
+            }
+        }
+        return exact.entries.empty() ? 1.0 : static_cast<double>(found) / exact.entries.size();
+    }
+
+} // namespace bench
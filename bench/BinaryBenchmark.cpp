@@ -0,0 +1,85 @@
+// Standalone benchmark of binary (sign-bit) embeddings: Hamming prefilter + exact cosine re-rank against float32
+//
+// MSVC:  cl /O2 /EHsc /std:c++17 /I include bench\BinaryBenchmark.cpp src\Quantization.cpp src\Similarity.cpp src\ThreadPool.cpp src\Matrix.cpp src\SimdKernels.cpp
+// GCC:   g++ -O2 -std=c++17 -Iinclude bench/BinaryBenchmark.cpp src/Quantization.cpp src/Similarity.cpp src/ThreadPool.cpp src/Matrix.cpp src/SimdKernels.cpp
+//
+// Usage: BinaryBenchmark [N] [Q] [D] [K]   (defaults 100000 corpus x 100 queries x 512, recall@10)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "BenchUtils.h"
+#include "math/Quantization.h"
+#include "math/Similarity.h"
+#include "math/SimdKernels.h"
+
+int main(int argc, char* argv[]) {
+    size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    size_t q = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100;
+    size_t d = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 512;
+    size_t k = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 10;
+
+    using Clock = std::chrono::steady_clock;
+    std::mt19937 rng(42);
+
+    math::Matrix centers(std::max<size_t>(n / 200, 1), d);
+    std::normal_distribution<float> gauss(0.0f, 1.0f);
+    for (size_t i = 0; i < centers.rows() * d; ++i) {
+        centers.data()[i] = gauss(rng);
+    }
+    math::normalizeRows(centers);
+
+    math::Matrix corpus = bench::clusteredMatrix(centers, n, 0.05f, rng);
+    math::Matrix queries = bench::clusteredMatrix(centers, q, 0.05f, rng);
+
+    std::cout << "Corpus " << n << " x " << d << ", " << q << " queries, recall@" << k
+              << ", kernels " << math::simdLevelName(math::activeSimdLevel()) << std::endl;
+
+    math::TopK exact = math::topKDotProduct(queries, corpus, k);
+
+    // Linear float scan, the baseline the prefilter replaces
+    auto start = Clock::now();
+    std::vector<math::ScoredIndex> scores(n);
+    for (size_t i = 0; i < q; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            scores[j] = { static_cast<uint32_t>(j), math::dotProduct(queries.row(i), corpus.row(j), d) };
+        }
+        std::partial_sort(scores.begin(), scores.begin() + std::min(k, n), scores.end(),
+            [](const math::ScoredIndex& a, const math::ScoredIndex& b) { return a.score > b.score; });
+    }
+    double floatUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / q;
+
+    // ITQ rotation learned on a sample of the corpus
+    const size_t trainRows = std::min(n, std::max<size_t>(d, 10000));
+    start = Clock::now();
+    math::Matrix rotation = math::learnBinaryRotation({ corpus.data(), trainRows, d });
+    double rotationMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    math::BinaryMatrix plain = math::BinaryMatrix::encode(corpus);
+    math::BinaryMatrix rotated = math::BinaryMatrix::encode(corpus, rotation);
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "Memory: float32 " << (n * d * sizeof(float) >> 10) << " KB, binary " << (plain.bytes() >> 10) << " KB" << std::endl
+              << "ITQ rotation on " << trainRows << " samples: " << rotationMs << " ms" << std::endl
+              << "Float linear scan: " << floatUs << " us/query" << std::endl;
+
+    std::cout << "\ncandidates   rotation   recall   us/query" << std::endl;
+    for (size_t multiplier : { 1, 4, 10, 50, 100 }) {
+        const size_t candidates = k * multiplier;
+        for (const math::BinaryMatrix* codes : { &plain, &rotated }) {
+            start = Clock::now();
+            math::TopK matches = math::topKBinaryRerank(queries, *codes, corpus, k, candidates);
+            double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / q;
+
+            std::cout << std::setw(10) << candidates << std::setw(11) << (codes == &rotated ? "itq" : "none")
+                      << std::setw(9) << std::setprecision(4) << bench::recallAtK(exact, matches)
+                      << std::setw(11) << std::setprecision(1) << us << std::endl;
+        }
+    }
+
+    return 0;
+}
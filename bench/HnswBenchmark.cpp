@@ -0,0 +1,83 @@
+// Standalone recall / latency benchmark of ann::HnswIndex against exact math::topKDotProduct
+//
+// MSVC:  cl /O2 /EHsc /std:c++17 /I include bench\HnswBenchmark.cpp src\HnswIndex.cpp src\Similarity.cpp src\ThreadPool.cpp src\Matrix.cpp src\SimdKernels.cpp
+// GCC:   g++ -O2 -std=c++17 -Iinclude bench/HnswBenchmark.cpp src/HnswIndex.cpp src/Similarity.cpp src/ThreadPool.cpp src/Matrix.cpp src/SimdKernels.cpp
+//
+// Usage: HnswBenchmark [N] [Q] [D] [K]   (defaults 20000 corpus x 200 queries x 512, recall@10)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "BenchUtils.h"
+#include "ann/HnswIndex.h"
+#include "math/Similarity.h"
+#include "math/SimdKernels.h"
+
+int main(int argc, char* argv[]) {
+    size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    size_t q = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200;
+    size_t d = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 512;
+    size_t k = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 10;
+
+    using Clock = std::chrono::steady_clock;
+    std::mt19937 rng(42);
+
+    math::Matrix centers(std::max<size_t>(n / 200, 1), d);
+    std::normal_distribution<float> gauss(0.0f, 1.0f);
+    for (size_t i = 0; i < centers.rows() * d; ++i) {
+        centers.data()[i] = gauss(rng);
+    }
+    math::normalizeRows(centers);
+
+    math::Matrix corpus = bench::clusteredMatrix(centers, n, 0.05f, rng);
+    math::Matrix queries = bench::clusteredMatrix(centers, q, 0.05f, rng);
+
+    std::cout << "Corpus " << n << " x " << d << ", " << q << " queries, recall@" << k << std::endl;
+
+    auto start = Clock::now();
+    math::TopK exact = math::topKDotProduct(queries, corpus, k);
+    double exactMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    // Exact search one query at a time (linear scan), the latency an interactive search would see
+    std::vector<math::ScoredIndex> scores(n);
+    start = Clock::now();
+    for (size_t i = 0; i < q; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            scores[j] = { static_cast<uint32_t>(j), math::dotProduct(queries.row(i), corpus.row(j), d) };
+        }
+        std::partial_sort(scores.begin(), scores.begin() + std::min(k, n), scores.end(),
+            [](const math::ScoredIndex& a, const math::ScoredIndex& b) { return a.score > b.score; });
+    }
+    double exactSingleUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / q;
+
+    std::cout << "Exact:  batched top-K " << std::fixed << std::setprecision(2) << exactMs << " ms total, linear scan "
+              << exactSingleUs << " us/query" << std::endl;
+
+    ann::HnswIndex index(d);
+    start = Clock::now();
+    index.build(corpus);
+    double buildMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::cout << "HNSW build (M=" << index.options().m << ", efConstruction=" << index.options().efConstruction << "): "
+              << buildMs << " ms" << std::endl;
+
+    std::cout << "\n    ef   recall   us/query   speedup" << std::endl;
+    for (size_t ef : { 10, 16, 32, 64, 128, 256, 512 }) {
+        if (ef < k) {
+            continue;
+        }
+
+        start = Clock::now();
+        math::TopK approx = index.search(queries, k, ef);
+        double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / q;
+
+        std::cout << std::setw(6) << ef << std::setw(9) << std::setprecision(4) << bench::recallAtK(exact, approx)
+                  << std::setw(11) << std::setprecision(1) << us
+                  << std::setw(9) << std::setprecision(1) << exactSingleUs / us << "x" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+// Standalone recall / latency / memory benchmark of ann::IvfPqIndex against exact math::topKDotProduct
+//
+// MSVC:  cl /O2 /EHsc /std:c++17 /I include bench\IvfPqBenchmark.cpp src\IvfPqIndex.cpp src\KMeans.cpp src\Similarity.cpp src\ThreadPool.cpp src\Matrix.cpp src\SimdKernels.cpp
+// GCC:   g++ -O2 -std=c++17 -Iinclude bench/IvfPqBenchmark.cpp src/IvfPqIndex.cpp src/KMeans.cpp src/Similarity.cpp src/ThreadPool.cpp src/Matrix.cpp src/SimdKernels.cpp
+//
+// Usage: IvfPqBenchmark [N] [Q] [D] [K] [LISTS] [SUBSPACES]   (defaults 50000 x 200 x 512, recall@10, 256 lists, 64 bytes/vector)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "BenchUtils.h"
+#include "ann/IvfPqIndex.h"
+#include "math/Similarity.h"
+
+int main(int argc, char* argv[]) {
+    size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50000;
+    size_t q = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200;
+    size_t d = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 512;
+    size_t k = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 10;
+
+    ann::IvfPqOptions options;
+    options.lists = argc > 5 ? std::strtoul(argv[5], nullptr, 10) : 256;
+    options.subspaces = argc > 6 ? std::strtoul(argv[6], nullptr, 10) : 64;
+
+    using Clock = std::chrono::steady_clock;
+    std::mt19937 rng(42);
+
+    math::Matrix centers(std::max<size_t>(n / 200, 1), d);
+    std::normal_distribution<float> gauss(0.0f, 1.0f);
+    for (size_t i = 0; i < centers.rows() * d; ++i) {
+        centers.data()[i] = gauss(rng);
+    }
+    math::normalizeRows(centers);
+
+    math::Matrix corpus = bench::clusteredMatrix(centers, n, 0.05f, rng);
+    math::Matrix queries = bench::clusteredMatrix(centers, q, 0.05f, rng);
+
+    std::cout << "Corpus " << n << " x " << d << ", " << q << " queries, recall@" << k
+              << ", " << options.lists << " lists, " << options.subspaces << " code bytes" << std::endl;
+
+    auto start = Clock::now();
+    math::TopK exact = math::topKDotProduct(queries, corpus, k);
+    double exactUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / q;
+
+    ann::IvfPqIndex index(d, options);
+    start = Clock::now();
+    index.train(corpus);
+    double trainMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    start = Clock::now();
+    index.add(corpus);
+    double addMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "Train " << trainMs << " ms, add " << addMs << " ms" << std::endl
+              << "Memory: float32 " << (n * d * sizeof(float) >> 10) << " KB, IVF-PQ codes + ids "
+              << (index.codeBytes() >> 10) << " KB" << std::endl
+              << "Exact batched top-K: " << exactUs << " us/query" << std::endl;
+
+    std::cout << "\nnprobe  rerank   recall   us/query" << std::endl;
+    for (size_t nprobe : { 1, 4, 8, 16, 32, 64 }) {
+        if (nprobe > options.lists) {
+            continue;
+        }
+        for (size_t rerank : { size_t(0), 10 * k }) {
+            ann::IvfPqSearchOptions search;
+            search.nprobe = nprobe;
+            search.rerank = rerank;
+            search.vectors = corpus;
+
+            start = Clock::now();
+            math::TopK approx = index.search(queries, k, search);
+            double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / q;
+
+            std::cout << std::setw(6) << nprobe << std::setw(8) << rerank
+                      << std::setw(9) << std::setprecision(4) << bench::recallAtK(exact, approx)
+                      << std::setw(11) << std::setprecision(1) << us << std::endl;
+        }
+    }
+
+    return 0;
+}
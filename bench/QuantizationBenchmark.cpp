@@ -0,0 +1,118 @@
+// Standalone accuracy / speed / memory benchmark of int8 and fp16 embedding storage against float32
+//
+// MSVC:  cl /O2 /EHsc /std:c++17 /I include bench\QuantizationBenchmark.cpp src\Quantization.cpp src\Similarity.cpp src\ThreadPool.cpp src\Matrix.cpp src\SimdKernels.cpp
+// GCC:   g++ -O2 -std=c++17 -Iinclude bench/QuantizationBenchmark.cpp src/Quantization.cpp src/Similarity.cpp src/ThreadPool.cpp src/Matrix.cpp src/SimdKernels.cpp
+//
+// Usage: QuantizationBenchmark [N] [Q] [D] [K]   (defaults 50000 corpus x 100 queries x 512, recall@10)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "BenchUtils.h"
+#include "math/Quantization.h"
+#include "math/Similarity.h"
+#include "math/SimdKernels.h"
+
+namespace {
+
+    // Max and mean |approximate - float| score over all query / corpus pairs
+    template <typename Score>
+    void scoreError(const math::Matrix& queries, const math::Matrix& corpus, Score&& score, double& maxError, double& meanError) {
+        maxError = 0.0;
+        double total = 0.0;
+        for (size_t i = 0; i < queries.rows(); ++i) {
+            for (size_t j = 0; j < corpus.rows(); ++j) {
+                double exact = math::dotProduct(queries.row(i), corpus.row(j), corpus.cols());
+                double error = std::fabs(score(i, j) - exact);
+                maxError = std::max(maxError, error);
+                total += error;
+            }
+        }
+        meanError = total / static_cast<double>(queries.rows() * corpus.rows());
+    }
+
+    void printRow(const char* name, size_t bytes, double us, double recall, double maxError, double meanError) {
+        std::cout << std::left << std::setw(9) << name << std::right
+                  << std::setw(10) << (bytes >> 10) << " KB"
+                  << std::setw(10) << std::setprecision(1) << us
+                  << std::setw(9) << std::setprecision(4) << recall
+                  << std::setw(12) << std::scientific << std::setprecision(2) << maxError
+                  << std::setw(11) << meanError << std::fixed << std::endl;
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50000;
+    size_t q = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100;
+    size_t d = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 512;
+    size_t k = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 10;
+
+    using Clock = std::chrono::steady_clock;
+    std::mt19937 rng(42);
+
+    math::Matrix centers(std::max<size_t>(n / 200, 1), d);
+    std::normal_distribution<float> gauss(0.0f, 1.0f);
+    for (size_t i = 0; i < centers.rows() * d; ++i) {
+        centers.data()[i] = gauss(rng);
+    }
+    math::normalizeRows(centers);
+
+    math::Matrix corpus = bench::clusteredMatrix(centers, n, 0.05f, rng);
+    math::Matrix queries = bench::clusteredMatrix(centers, q, 0.05f, rng);
+
+    math::Int8Matrix corpusInt8 = math::Int8Matrix::quantize(corpus);
+    math::Fp16Matrix corpusFp16 = math::Fp16Matrix::convert(corpus);
+
+    std::cout << "Corpus " << n << " x " << d << ", " << q << " queries, recall@" << k
+              << ", kernels " << math::simdLevelName(math::activeSimdLevel()) << std::endl;
+
+    math::TopK exact = math::topKDotProduct(queries, corpus, k);
+
+    // Linear scan with the float kernel, the baseline the compressed scans replace
+    auto start = Clock::now();
+    std::vector<math::ScoredIndex> scores(n);
+    for (size_t i = 0; i < q; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            scores[j] = { static_cast<uint32_t>(j), math::dotProduct(queries.row(i), corpus.row(j), d) };
+        }
+        std::partial_sort(scores.begin(), scores.begin() + std::min(k, n), scores.end(),
+            [](const math::ScoredIndex& a, const math::ScoredIndex& b) { return a.score > b.score; });
+    }
+    double floatUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / q;
+
+    start = Clock::now();
+    math::TopK int8Matches = math::topKDotProduct(queries, corpusInt8, k);
+    double int8Us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / q;
+
+    start = Clock::now();
+    math::TopK fp16Matches = math::topKDotProduct(queries, corpusFp16, k);
+    double fp16Us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / q;
+
+    // Score errors on a subset, all pairs would be q * n float dots per format
+    const size_t errorRows = std::min<size_t>(n, 5000);
+    math::Matrix errorCorpus(errorRows, d);
+    std::copy(corpus.data(), corpus.data() + errorRows * d, errorCorpus.data());
+
+    std::vector<int8_t> query(d);
+    double int8Max = 0.0, int8Mean = 0.0, fp16Max = 0.0, fp16Mean = 0.0;
+    scoreError(queries, errorCorpus, [&](size_t i, size_t j) {
+        float queryScale = math::quantizeInt8(queries.row(i), d, query.data());
+        return static_cast<double>(math::dotProductInt8(query.data(), corpusInt8.row(j), d)) * queryScale * corpusInt8.scale(j);
+    }, int8Max, int8Mean);
+    scoreError(queries, errorCorpus, [&](size_t i, size_t j) {
+        return static_cast<double>(math::dotProductFp16(queries.row(i), corpusFp16.row(j), d));
+    }, fp16Max, fp16Mean);
+
+    std::cout << std::fixed << "\nformat       memory  us/query   recall   max error  mean error" << std::endl;
+    printRow("float32", n * d * sizeof(float), floatUs, 1.0, 0.0, 0.0);
+    printRow("fp16", corpusFp16.bytes(), fp16Us, bench::recallAtK(exact, fp16Matches), fp16Max, fp16Mean);
+    printRow("int8", corpusInt8.bytes(), int8Us, bench::recallAtK(exact, int8Matches), int8Max, int8Mean);
+
+    return 0;
+}
@@ -0,0 +1,84 @@
+// Standalone microbenchmark for the dispatched dot product / L2 norm kernels
+//
+// MSVC:  cl /O2 /EHsc /std:c++17 /I include bench\SimdBenchmark.cpp src\SimdKernels.cpp
+// GCC:   g++ -O2 -std=c++17 -Iinclude bench/SimdBenchmark.cpp src/SimdKernels.cpp
+//
+// Runs every kernel level supported by the CPU on dimensions 512, 768 and 1024
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include "math/SimdKernels.h"
+
+namespace {
+
+    double referenceDot(const float* a, const float* b, size_t n) {
+        double sum = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            sum += static_cast<double>(a[i]) * b[i];
+        }
+        return sum;
+    }
+
+} // namespace
+
+int main() {
+    const size_t dims[] = { 512, 768, 1024 };
+    const size_t vectors = 4096;
+    const int repeats = 50;
+
+    std::mt19937 rng(42);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+
+    const math::SimdLevel best = math::detectSimdLevel();
+    std::cout << "Detected: " << math::simdLevelName(best) << std::endl;
+
+    for (size_t dim : dims) {
+        // Corpus bigger than L1 so loads are realistic, one query vector
+        std::vector<float> corpus(vectors * dim);
+        std::vector<float> query(dim);
+        for (float& v : corpus) v = dist(rng);
+        for (float& v : query) v = dist(rng);
+
+        std::cout << "\ndim " << dim << std::endl;
+        for (int level = 0; level <= static_cast<int>(best); ++level) {
+            math::setSimdLevel(static_cast<math::SimdLevel>(level));
+
+            double maxRelError = 0.0;
+            for (size_t i = 0; i < 64; ++i) {
+                double exact = referenceDot(query.data(), corpus.data() + i * dim, dim);
+                double got = math::dotProduct(query.data(), corpus.data() + i * dim, dim);
+                maxRelError = std::max(maxRelError, std::fabs(got - exact) / (std::fabs(exact) + 1e-6));
+            }
+
+            volatile float sink = 0.0f;
+            auto start = std::chrono::steady_clock::now();
+            for (int r = 0; r < repeats; ++r) {
+                for (size_t i = 0; i < vectors; ++i) {
+                    sink = sink + math::dotProduct(query.data(), corpus.data() + i * dim, dim);
+                }
+            }
+            auto mid = std::chrono::steady_clock::now();
+            for (int r = 0; r < repeats; ++r) {
+                for (size_t i = 0; i < vectors; ++i) {
+                    sink = sink + math::squaredL2Norm(corpus.data() + i * dim, dim);
+                }
+            }
+            auto end = std::chrono::steady_clock::now();
+
+            const double calls = static_cast<double>(repeats) * vectors;
+            double dotNs = std::chrono::duration<double, std::nano>(mid - start).count() / calls;
+            double normNs = std::chrono::duration<double, std::nano>(end - mid).count() / calls;
+            std::cout << "  " << std::setw(7) << math::simdLevelName(math::activeSimdLevel())
+                      << "  dot " << std::fixed << std::setprecision(1) << dotNs << " ns"
+                      << "  norm " << normNs << " ns"
+                      << "  max rel error " << std::scientific << std::setprecision(2) << maxRelError
+                      << std::defaultfloat << std::endl;
+        }
+    }
+
+    return 0;
+}
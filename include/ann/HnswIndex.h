@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <utility>
+#include <vector>
+#include "../config/Config.h"
+#include "../math/Matrix.h"
+#include "../math/Similarity.h"
+
+namespace ann {
+
+    struct HnswOptions {
+        size_t m = config::DEFAULT_HNSW_M;
+        size_t efConstruction = config::DEFAULT_HNSW_EF_CONSTRUCTION;
+        uint32_t seed = 42;
+    };
+
+    // Hierarchical navigable small world graph over cosine similarity
+    // Vectors are copied and L2-normalized on insert, so scores match math::topKSimilarity
+    // insert() is single-threaded; search() is const and may run from several threads at once
+    class HnswIndex {
+    public:
+        static constexpr uint32_t FORMAT_VERSION = 1;
+
+        explicit HnswIndex(size_t dim, HnswOptions options = {});
+
+        // Add one vector and return its row index (rows are numbered in insertion order)
+        uint32_t insert(const float* vector);
+
+        // Insert every row of vectors
+        void build(const math::MatrixView& vectors);
+
+        // Approximate top-k by cosine, sorted by descending score
+        // ef is the candidate list size on the bottom layer, raised to k if smaller
+        std::vector<math::ScoredIndex> search(const float* query, size_t k, size_t ef = config::DEFAULT_HNSW_EF_SEARCH) const;
+        math::TopK search(const math::MatrixView& queries, size_t k, size_t ef = config::DEFAULT_HNSW_EF_SEARCH) const;
+
+        size_t size() const { return levels_.size(); }
+        size_t dim() const { return dim_; }
+        bool empty() const { return levels_.empty(); }
+        const HnswOptions& options() const { return options_; }
+
+        void save(const std::filesystem::path& filePath) const;
+        static HnswIndex load(const std::filesystem::path& filePath);
+
+    private:
+        // (similarity, node)
+        using Candidate = std::pair<float, uint32_t>;
+
+        size_t maxLinks(int level) const { return level == 0 ? 2 * options_.m : options_.m; }
+
+        // Link block of node on level: [count, neighbour ids...]
+        uint32_t* linkBlock(uint32_t node, int level);
+        const uint32_t* linkBlock(uint32_t node, int level) const;
+
+        int randomLevel();
+        float similarity(const float* query, uint32_t node) const;
+
+        // Greedy walk towards query through levels [fromLevel, toLevel)
+        uint32_t descend(const float* query, uint32_t entry, int fromLevel, int toLevel) const;
+
+        // Best-first search on one level, result sorted by descending similarity
+        std::vector<Candidate> searchLayer(const float* query, uint32_t entry, size_t ef, int level) const;
+
+        // Keep candidates that are closer to the query than to any already selected neighbour
+        std::vector<uint32_t> selectNeighbors(const std::vector<Candidate>& candidates, size_t maxCount) const;
+
+        // Add a back link, pruning neighbour list of node when it is full
+        void connect(uint32_t node, uint32_t neighbor, int level);
+
+        size_t dim_;
+        HnswOptions options_;
+
+        math::Matrix vectors_;
+        std::vector<int> levels_;
+        std::vector<uint32_t> baseLinks_;                 // level 0, fixed stride per node
+        std::vector<std::vector<uint32_t>> upperLinks_;   // levels 1..levels_[i] of node i
+
+        int maxLevel_;
+        uint32_t entryPoint_;
+        double levelMultiplier_;
+        std::mt19937 rng_;
+    };
+
+} // namespace ann
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+#include "../config/Config.h"
+#include "../math/Matrix.h"
+#include "../math/Similarity.h"
+
+namespace ann {
+
+    struct IvfPqOptions {
+        size_t lists = config::DEFAULT_IVF_LISTS;
+        size_t subspaces = config::DEFAULT_PQ_SUBSPACES;
+        size_t iterations = 20;                 // k-means iterations for both quantizers
+        uint32_t seed = 42;
+    };
+
+    struct IvfPqSearchOptions {
+        size_t nprobe = config::DEFAULT_IVF_NPROBE;
+        // Number of PQ candidates re-scored exactly against vectors; 0 disables re-ranking
+        size_t rerank = 0;
+        // Full vectors by row, e.g. EmbeddingStore::vectors() of a memory-mapped store
+        math::MatrixView vectors;
+    };
+
+    // Inverted file with product quantization over cosine similarity
+    // Every vector is stored as its coarse list plus `subspaces` code bytes of the residual to the list centroid,
+    // e.g. 64 bytes instead of 2 KB for a 512-d embedding. Scores are q . centroid + sum of per-subspace table
+    // lookups (asymmetric distance computation); the table depends only on the query, so it is built once per search
+    class IvfPqIndex {
+    public:
+        static constexpr uint32_t FORMAT_VERSION = 1;
+        static constexpr size_t CODEBOOK_SIZE = 256;    // one byte per subspace code
+        static constexpr size_t BLOCK_SIZE = 16;        // codes are interleaved in blocks for the SIMD scan
+
+        explicit IvfPqIndex(size_t dim, IvfPqOptions options = {});
+
+        // Learn coarse centroids and PQ codebooks; needs at least max(lists, 256) samples
+        void train(const math::MatrixView& samples);
+        bool isTrained() const { return trained_; }
+
+        // Encode and append rows, numbered in insertion order
+        void add(const math::MatrixView& vectors);
+
+        std::vector<math::ScoredIndex> search(const float* query, size_t k, const IvfPqSearchOptions& options = {}) const;
+        math::TopK search(const math::MatrixView& queries, size_t k, const IvfPqSearchOptions& options = {}) const;
+
+        size_t size() const { return count_; }
+        size_t dim() const { return dim_; }
+        const IvfPqOptions& options() const { return options_; }
+
+        // Bytes used by codes and ids, without the trained quantizers
+        size_t codeBytes() const;
+
+        void save(const std::filesystem::path& filePath) const;
+        static IvfPqIndex load(const std::filesystem::path& filePath);
+
+    private:
+        struct InvertedList {
+            std::vector<uint32_t> ids;
+            std::vector<uint8_t> codes;     // blocks of [subspaces, BLOCK_SIZE]
+        };
+
+        size_t subspaceDim() const { return dim_ / options_.subspaces; }
+
+        // Transposed copy of the codebooks used to build query tables
+        void buildCodebookColumns();
+
+        // Append codes of one vector to list
+        void appendCode(InvertedList& list, uint32_t id, const uint8_t* code) const;
+
+        size_t dim_;
+        IvfPqOptions options_;
+        bool trained_;
+        size_t count_;
+
+        math::Matrix centroids_;                    // [lists, dim]
+        math::Matrix codebooks_;                    // [subspaces * 256, dim / subspaces]
+        math::Matrix codebookColumns_;              // [dim, 256], row c holds coordinate c of every codeword
+        std::vector<InvertedList> lists_;
+    };
+
+} // namespace ann
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../math/Matrix.h"
+
+namespace ann {
+
+    struct KMeansOptions {
+        size_t iterations = 20;
+        size_t maxSamplesPerCentroid = 256;     // larger training sets are randomly subsampled
+        uint32_t seed = 42;
+    };
+
+    // Lloyd's k-means under L2 distance, returns [k, D] centroids
+    // Assignment runs as one blocked GEMM per iteration; empty clusters are re-seeded from random points
+    math::Matrix trainKMeans(const math::MatrixView& data, size_t k, const KMeansOptions& options = {});
+
+    // Index of the nearest centroid (L2) for every row of data
+    std::vector<uint32_t> assignNearest(const math::MatrixView& data, const math::MatrixView& centroids);
+
+} // namespace ann
@@ -5,28 +5,102 @@
 #include <string>
 #include <filesystem>
 #include <memory>
+#include <unordered_map>
 #include "../onnx/ONNXInference.h"
 #include "../text/Tokenizer.h"
 #include "../image/ImageProcessor.h"
+#include "../math/Matrix.h"
+#include "../store/EmbeddingCache.h"
 
 namespace clip {
 
+    // Multi-crop embedding of one image
+    struct TiledEmbedding {
+        std::vector<float> global;                  // whole image squashed to 224x224
+        std::vector<std::vector<float>> tiles;      // row-major grid order, same order as tileRects
+        std::vector<image::TileRect> tileRects;     // tile regions in source pixel coordinates
+        std::vector<float> pooled;                  // mean of L2-normalized global and tile embeddings
+                                                    // (itself unit-length if the encoder normalizes)
+    };
+
     class CLIPInference {
     public:
-        CLIPInference(const std::filesystem::path& modelsDir);
+        // With normalizeEmbeddings every returned and cached embedding is scaled to unit L2 norm,
+        // so similarity is a plain dot product (math::cosineSimilarityNormalized, math::topKDotProduct)
+        CLIPInference(const std::filesystem::path& modelsDir, bool normalizeEmbeddings = false);
         ~CLIPInference();
 
         // Encode image to embedding
         std::vector<float> encodeImage(const std::filesystem::path& imagePath);
 
+        // Encode image from encoded bytes in memory (JPEG, PNG, ...)
+        std::vector<float> encodeImage(const uint8_t* data, size_t size);
+
+        // Load and preprocess image without running the encoder
+        // Safe to call concurrently from several threads
+        std::vector<float> preprocessImage(const std::filesystem::path& imagePath) const;
+        std::vector<float> preprocessImage(const uint8_t* data, size_t size) const;
+
+        // Encode preprocessed images packed as [batchSize, 3, 224, 224]
+        // Returns one embedding per image; safe to call concurrently
+        std::vector<std::vector<float>> encodeImageBatch(const std::vector<float>& batchTensor, size_t batchSize);
+
+        // Encode image as global view plus grid of overlapping tiles
+        // All views go through the encoder in one batch if the model has a dynamic batch axis
+        TiledEmbedding encodeImageTiled(const std::filesystem::path& imagePath, const image::TileOptions& options);
+
+        // True if image_encoder.onnx accepts more than one image per run
+        bool supportsImageBatch() const { return imageBatchDynamic_; }
+
+        // True if image_encoder.onnx takes raw uint8 pixels (normalization folded into the graph)
+        // In that case images must go through the uint8 variants below
+        bool hasUint8ImageInput() const { return imageInputUint8_; }
+
+        // Load image as packed uint8 tensor in the layout expected by the encoder
+        std::vector<uint8_t> preprocessImageUint8(const std::filesystem::path& imagePath) const;
+        std::vector<uint8_t> preprocessImageUint8(const uint8_t* data, size_t size) const;
+
+        // Encode uint8 images packed as [batchSize, 3, 224, 224] or [batchSize, 224, 224, 3]
+        std::vector<std::vector<float>> encodeImageBatch(const std::vector<uint8_t>& batchTensor, size_t batchSize);
+
+        // Keep image embeddings in cacheFile keyed by the content of the encoded file, so encodeImage
+        // on an image seen before (re-run, duplicate under another name) skips decode and inference
+        // The file is tied to the content of the image encoder and the preprocessing settings
+        void setImageCache(const std::filesystem::path& cacheFile);
+        bool hasImageCache() const { return imageCache_ != nullptr; }
+
+        // Bump when imageContentKey() changes, so caches keyed the old way are replaced instead of never hit
+        static constexpr uint32_t IMAGE_KEY_VERSION = 2;
+
+        // Image cache key of encoded bytes: 128-bit content hash (utils::hash128) plus size
+        static std::string imageContentKey(const uint8_t* data, size_t size);
+
+        // Image cache access for callers that run the encoder themselves (ImagePipeline); safe to call concurrently
+        // findCachedImage returns false on a miss or without an image cache
+        bool findCachedImage(const std::string& key, std::vector<float>& embedding) const;
+        void cacheImage(const std::string& key, const std::vector<float>& embedding);
+
+        // Write new image cache entries to disk; also happens on destruction
+        void flushImageCache();
+
         // Encode text to embedding
         std::vector<float> encodeText(const std::string& text);
 
+        // Keep text embeddings in cacheFile across runs so encodeText only runs the encoder for new prompts
+        // Entries are keyed by prompt and tied to the content of the text encoder and tokenizer files,
+        // so a different model or vocabulary starts a fresh cache. Created on the first flush
+        void setTextCache(const std::filesystem::path& cacheFile);
+
         // Encode multiple texts (with caching)
-        std::vector<std::vector<float>> encodeTexts(const std::vector<std::string>& texts);
+        // Every distinct prompt gets a cache slot on first use, so only prompts not seen before are encoded
+        // Returns [texts.size(), D] in input order; the view stays valid until the next encodeTexts call
+        math::MatrixView encodeTexts(const std::vector<std::string>& texts);
+
+        // True if embeddings are returned unit-length
+        bool normalizesEmbeddings() const { return normalizeEmbeddings_; }
 
-        // Get cached text embeddings
-        const std::vector<std::vector<float>>& getCachedTextEmbeddings() const { return cachedTextEmbeddings_; }
+        // Get cached text embeddings, one row per distinct prompt in first-seen order
+        math::MatrixView getCachedTextEmbeddings() const { return textEmbeddings_.view(); }
 
     private:
         Ort::Env env_;
@@ -35,9 +109,30 @@ namespace clip {
         std::unique_ptr<text::Tokenizer> tokenizer_;
         std::unique_ptr<image::ImageProcessor> imageProcessor_;
 
+        bool normalizeEmbeddings_;
+
+        // Image encoder input format
+        bool imageInputUint8_;
+        bool imageBatchDynamic_;
+        image::TensorLayout imageInputLayout_;
+
+        // Split [batchSize, D] encoder output into per-image embeddings
+        std::vector<std::vector<float>> splitBatchOutput(const std::vector<float>& output, size_t batchSize) const;
+
+        // Encode image bytes without consulting the image cache
+        std::vector<float> encodeImageBytes(const uint8_t* data, size_t size);
+
+        // Normalize in place if normalizeEmbeddings is on
+        void finishEmbedding(std::vector<float>& embedding) const;
+
+        std::filesystem::path modelsDir_;
+
         // Caching
-        std::vector<std::string> cachedTexts_;
-        std::vector<std::vector<float>> cachedTextEmbeddings_;
+        std::unique_ptr<store::EmbeddingCache> textCache_;
+        std::unique_ptr<store::EmbeddingCache> imageCache_;
+        std::unordered_map<std::string, size_t> textSlots_;     // prompt -> row of textEmbeddings_
+        math::Matrix textEmbeddings_;
+        math::Matrix textBatch_;                                // encodeTexts result when slots are out of order
     };
 
 } // namespace clip
@@ -32,11 +32,43 @@ namespace config {
     // Default values
     inline constexpr int DEFAULT_MAX_IMAGES = 10;
     inline constexpr int DEFAULT_TOP_K = 3;
+    inline constexpr int DEFAULT_SCAN_THREADS = 1;       // >1 lists subdirectories in parallel
+
+    // Image encoding pipeline
+    inline constexpr int DEFAULT_DECODE_THREADS = 0;     // 0 = hardware concurrency
+    inline constexpr int DEFAULT_INFERENCE_THREADS = 1;
+    inline constexpr int DEFAULT_BATCH_SIZE = 1;         // >1 requires a model with dynamic batch axis
+    inline constexpr int DEFAULT_QUEUE_DEPTH = 4;        // ready batches waiting for inference
+    inline constexpr int DEFAULT_PREFETCH_THREADS = 0;   // 0 = decoders read files themselves
+    inline constexpr int DEFAULT_PREFETCH_MB = 64;       // read-ahead budget
+
+    // Multi-crop image embedding
+    inline constexpr int DEFAULT_TILE_GRID = 2;
+    inline constexpr float DEFAULT_TILE_OVERLAP = 0.25f;
+
+    // HNSW approximate nearest-neighbour index
+    inline constexpr int DEFAULT_HNSW_M = 16;                // links per node, 2 * M on the bottom layer
+    inline constexpr int DEFAULT_HNSW_EF_CONSTRUCTION = 200;
+    inline constexpr int DEFAULT_HNSW_EF_SEARCH = 64;        // candidate list size, trades recall for latency
+
+    // IVF-PQ compressed index
+    inline constexpr int DEFAULT_IVF_LISTS = 1024;           // coarse clusters, ~sqrt(N) is a good start
+    inline constexpr int DEFAULT_PQ_SUBSPACES = 64;          // code bytes per vector, must divide the dimension
+    inline constexpr int DEFAULT_IVF_NPROBE = 16;            // lists scanned per query
+
+    // Similarity search
+    inline constexpr int DEFAULT_SIMILARITY_THREADS = 0;     // 0 = hardware concurrency
 
     // Image file extensions
     inline constexpr const char* IMAGE_EXT_JPG = ".jpg";
     inline constexpr const char* IMAGE_EXT_JPEG = ".jpeg";
     inline constexpr const char* IMAGE_EXT_PNG = ".png";
+    inline constexpr const char* IMAGE_EXT_WEBP = ".webp";
+    inline constexpr const char* IMAGE_EXT_TIF = ".tif";
+    inline constexpr const char* IMAGE_EXT_TIFF = ".tiff";
+    inline constexpr const char* IMAGE_EXT_BMP = ".bmp";
+    inline constexpr const char* IMAGE_EXT_AVIF = ".avif";     // only with CLIP_HAVE_AVIF
+    inline constexpr const char* IMAGE_EXT_JXL = ".jxl";       // only with CLIP_HAVE_JXL
 
 } // namespace config
 
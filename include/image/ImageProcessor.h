@@ -1,6 +1,8 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
+#include <cstddef>
 #include <filesystem>
 #include <memory>
 
@@ -11,19 +13,68 @@ namespace cv {
 
 namespace image {
 
+    // Memory layout of a uint8 image tensor
+    enum class TensorLayout {
+        NCHW,   // [1, 3, 224, 224]
+        NHWC    // [1, 224, 224, 3]
+    };
+
+    // Region of the source image in pixel coordinates
+    struct TileRect {
+        int x;
+        int y;
+        int width;
+        int height;
+    };
+
+    // Multi-crop settings: grid x grid tiles, neighbours share `overlap` of the tile size
+    struct TileOptions {
+        int grid;
+        float overlap;
+    };
+
+    // Split width x height image into overlapping tiles, row-major order
+    std::vector<TileRect> computeTileGrid(int width, int height, const TileOptions& options);
+
     class ImageProcessor {
     public:
+        // Bump when preprocessing output changes for the same file, invalidates persisted image embeddings
+        static constexpr uint32_t VERSION = 1;
+
         ImageProcessor();
         ~ImageProcessor();
 
         // Load and preprocess image from file
         // Returns tensor as [1, 3, 224, 224] float32 vector
-        std::vector<float> preprocessImage(const std::filesystem::path& imagePath);
+        std::vector<float> preprocessImage(const std::filesystem::path& imagePath) const;
+
+        // Decode encoded image bytes (JPEG, PNG, ...) from memory and preprocess
+        // The buffer is only read and does not need to outlive the call
+        std::vector<float> preprocessImage(const uint8_t* data, size_t size) const;
 
         // Preprocess already loaded image
-        std::vector<float> preprocessImage(const cv::Mat& image);
+        std::vector<float> preprocessImage(const cv::Mat& image) const;
+
+        // Load, resize and pack image as raw RGB uint8 tensor without normalization
+        // For models with normalization folded into the graph (tools/fold_image_normalization.py)
+        std::vector<uint8_t> preprocessImageUint8(const std::filesystem::path& imagePath, TensorLayout layout) const;
+        std::vector<uint8_t> preprocessImageUint8(const uint8_t* data, size_t size, TensorLayout layout) const;
+        std::vector<uint8_t> preprocessImageUint8(const cv::Mat& image, TensorLayout layout) const;
+
+        // Load image once and pack the global view followed by the tiles into one batch
+        // Returns [1 + grid * grid, 3, 224, 224]; tile rectangles are written to `tiles`
+        std::vector<float> preprocessImageTiled(const std::filesystem::path& imagePath, const TileOptions& options, std::vector<TileRect>& tiles) const;
+        std::vector<uint8_t> preprocessImageTiledUint8(const std::filesystem::path& imagePath, const TileOptions& options, TensorLayout layout, std::vector<TileRect>& tiles) const;
 
     private:
+        // Load image from file or decode it from memory as BGR
+        cv::Mat loadImage(const std::filesystem::path& imagePath) const;
+        cv::Mat decodeImage(const uint8_t* data, size_t size) const;
+
+        // Resize to 224x224 and convert BGR to RGB
+        // Returned Mat shares thread-local scratch memory and is valid until the next call on this thread
+        cv::Mat resizeToModelInput(const cv::Mat& image) const;
+
         // Convert cv::Mat to tensor format [1, 3, 224, 224]
         std::vector<float> matToTensor(const cv::Mat& image) const;
 
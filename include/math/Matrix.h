@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace math {
+
+    // Allocator returning memory aligned to `Alignment` bytes (cache line / AVX-512 register)
+    template <typename T, size_t Alignment>
+    struct AlignedAllocator {
+        using value_type = T;
+
+        template <typename U>
+        struct rebind {
+            using other = AlignedAllocator<U, Alignment>;
+        };
+
+        AlignedAllocator() noexcept = default;
+        template <typename U>
+        AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+        T* allocate(size_t n) {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+        }
+
+        void deallocate(T* p, size_t) noexcept {
+            ::operator delete(p, std::align_val_t(Alignment));
+        }
+
+        template <typename U>
+        bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+        template <typename U>
+        bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept { return false; }
+    };
+
+    inline constexpr size_t MATRIX_ALIGNMENT = 64;
+
+    // Non-owning read-only view of row-major [rows, cols] floats
+    // Lets the math routines run on memory they do not own, e.g. a memory-mapped embedding store
+    struct MatrixView {
+        const float* data = nullptr;
+        size_t rows = 0;
+        size_t cols = 0;
+
+        bool empty() const { return rows == 0 || cols == 0; }
+        const float* row(size_t i) const { return data + i * cols; }
+        float operator()(size_t i, size_t j) const { return data[i * cols + j]; }
+    };
+
+    // Dense row-major [rows, cols] float matrix stored in one contiguous 64-byte aligned buffer
+    class Matrix {
+    public:
+        using Storage = std::vector<float, AlignedAllocator<float, MATRIX_ALIGNMENT>>;
+
+        Matrix() : rows_(0), cols_(0) {}
+        Matrix(size_t rows, size_t cols, float value = 0.0f) : rows_(rows), cols_(cols), data_(rows * cols, value) {}
+
+        // Copy vector-of-rows layout; all rows must have the same length
+        static Matrix fromRows(const std::vector<std::vector<float>>& rows);
+
+        // Copy rows of a view
+        static Matrix fromView(const MatrixView& view);
+
+        // Copy back to vector-of-rows layout
+        std::vector<std::vector<float>> toRows() const;
+
+        size_t rows() const { return rows_; }
+        size_t cols() const { return cols_; }
+        bool empty() const { return rows_ == 0 || cols_ == 0; }
+
+        float* data() { return data_.data(); }
+        const float* data() const { return data_.data(); }
+
+        float* row(size_t i) { return data_.data() + i * cols_; }
+        const float* row(size_t i) const { return data_.data() + i * cols_; }
+
+        float& operator()(size_t i, size_t j) { return data_[i * cols_ + j]; }
+        float operator()(size_t i, size_t j) const { return data_[i * cols_ + j]; }
+
+        MatrixView view() const { return { data_.data(), rows_, cols_ }; }
+        operator MatrixView() const { return view(); }
+
+        // Append one row; the first row fixes the column count
+        void appendRow(const float* values, size_t size);
+
+        // Preallocate storage for rows, e.g. before a loop of appendRow()
+        void reserveRows(size_t rows) { data_.reserve(rows * cols_); }
+
+    private:
+        size_t rows_;
+        size_t cols_;
+        Storage data_;
+    };
+
+} // namespace math
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Matrix.h"
+#include "Similarity.h"
+
+namespace math {
+
+    // Row-major [rows, cols] int8 embeddings with one float scale per row: value ~ data * scale
+    // Symmetric quantization to [-127, 127] by the row's max |value|; 4x smaller than float32
+    class Int8Matrix {
+    public:
+        Int8Matrix() : rows_(0), cols_(0) {}
+
+        static Int8Matrix quantize(const MatrixView& m);
+
+        // Quantize and append one row, e.g. an encoder output vector; the first row fixes the column count
+        void appendRow(const float* values, size_t size);
+
+        size_t rows() const { return rows_; }
+        size_t cols() const { return cols_; }
+        bool empty() const { return rows_ == 0 || cols_ == 0; }
+        size_t bytes() const { return data_.size() + scales_.size() * sizeof(float); }
+
+        const int8_t* row(size_t i) const { return data_.data() + i * cols_; }
+        float scale(size_t i) const { return scales_[i]; }
+
+        void dequantizeRow(size_t i, float* out) const;
+
+    private:
+        size_t rows_;
+        size_t cols_;
+        std::vector<int8_t> data_;
+        std::vector<float> scales_;
+    };
+
+    // Row-major [rows, cols] embeddings in IEEE half precision; 2x smaller than float32
+    class Fp16Matrix {
+    public:
+        Fp16Matrix() : rows_(0), cols_(0) {}
+
+        static Fp16Matrix convert(const MatrixView& m);
+
+        // Convert and append one row; the first row fixes the column count
+        void appendRow(const float* values, size_t size);
+
+        size_t rows() const { return rows_; }
+        size_t cols() const { return cols_; }
+        bool empty() const { return rows_ == 0 || cols_ == 0; }
+        size_t bytes() const { return data_.size() * sizeof(uint16_t); }
+
+        const uint16_t* row(size_t i) const { return data_.data() + i * cols_; }
+
+        void dequantizeRow(size_t i, float* out) const;
+
+    private:
+        size_t rows_;
+        size_t cols_;
+        std::vector<uint16_t> data_;
+    };
+
+    // Sign bits of (optionally rotated) embeddings packed into 64-bit words: 512 dims -> 64 bytes, 32x smaller than float32
+    // Meant as a first stage: Hamming distance between codes approximates angle between vectors
+    class BinaryMatrix {
+    public:
+        BinaryMatrix() : rows_(0), cols_(0), words_(0) {}
+
+        // rotation: [D, D] orthogonal matrix from learnBinaryRotation, applied as x * R before taking signs
+        explicit BinaryMatrix(const MatrixView& rotation);
+
+        static BinaryMatrix encode(const MatrixView& m, const MatrixView& rotation = {});
+
+        // Encode and append one row; the first row fixes the column count
+        void appendRow(const float* values, size_t size);
+
+        // Pack a query the same way as the rows; out receives words() words
+        void encodeQuery(const float* values, size_t size, uint64_t* out) const;
+
+        size_t rows() const { return rows_; }
+        size_t cols() const { return cols_; }
+        size_t words() const { return words_; }
+        bool empty() const { return rows_ == 0 || cols_ == 0; }
+        size_t bytes() const { return data_.size() * sizeof(uint64_t); }
+
+        const uint64_t* row(size_t i) const { return data_.data() + i * words_; }
+
+    private:
+        void packSigns(const float* values, uint64_t* out) const;
+
+        size_t rows_;
+        size_t cols_;
+        size_t words_;
+        std::vector<uint64_t> data_;
+        Matrix rotationColumns_;    // R^T, empty without rotation
+    };
+
+    // Iterative quantization (ITQ): orthogonal R that minimizes the loss of sign(x * R)
+    // Alternates codes B = sign(V * R) with the Procrustes solution R = polar(V^T * B); needs at least D samples
+    Matrix learnBinaryRotation(const MatrixView& samples, size_t iterations = 20, uint32_t seed = 42);
+
+    // Quantize one vector, returns its scale (0 for a zero vector)
+    float quantizeInt8(const float* values, size_t size, int8_t* out);
+
+    // Top-K by dot product against a compressed corpus, same ordering as math::topKDotProduct
+    // Inputs are expected to be L2-normalized like the float path
+    // int8: each query is quantized too and scored with the integer kernel, score = int dot * both scales
+    TopK topKDotProduct(const MatrixView& queries, const Int8Matrix& corpus, size_t k);
+    // fp16: float queries against half precision rows, converted inside the kernel
+    TopK topKDotProduct(const MatrixView& queries, const Fp16Matrix& corpus, size_t k);
+
+    // Two-stage search: the `candidates` codes closest in Hamming distance, then exact cosine against corpus rows
+    // corpus holds the float rows the codes were built from (e.g. a memory-mapped EmbeddingStore)
+    TopK topKBinaryRerank(const MatrixView& queries, const BinaryMatrix& codes, const MatrixView& corpus, size_t k, size_t candidates);
+
+} // namespace math
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace math {
+
+    // Instruction set used by the vector kernels, picked once at startup via CPUID
+    enum class SimdLevel {
+        Scalar,
+        SSE2,
+        AVX2,       // AVX2 + FMA
+        AVX512      // AVX-512F
+    };
+
+    // Best level supported by this CPU and OS
+    SimdLevel detectSimdLevel();
+
+    // Level currently used by the kernels below
+    SimdLevel activeSimdLevel();
+
+    // Force a kernel set, e.g. to compare levels in benchmarks
+    // Levels above detectSimdLevel() are clamped; not thread-safe, call before kernels are in use
+    void setSimdLevel(SimdLevel level);
+
+    const char* simdLevelName(SimdLevel level);
+
+    // Sum of a[i] * b[i]; several independent accumulators keep the FMA units busy
+    float dotProduct(const float* a, const float* b, size_t n);
+
+    // Sum of a[i] * a[i]
+    float squaredL2Norm(const float* a, size_t n);
+
+    // GEMM register tile used by math::matmulTransposed and top-K search:
+    // acc[r * 16 + j] += sum over k of aRows[r][k] * strip[k * 16 + j], r < 4, j < 16
+    void gemmKernel4x16(const float* const* aRows, const float* strip, size_t kc, float* acc);
+
+    // Product-quantization distance table lookup (ADC) over blocks of 16 codes
+    // lut: [subspaces, 256]; codes: per block [subspaces, 16] code bytes
+    // scores[b * 16 + j] = sum over s of lut[s * 256 + codes[b][s][j]]
+    void pqScanBlocks(const float* lut, const uint8_t* codes, size_t blocks, size_t subspaces, float* scores);
+
+    // Sum of a[i] * b[i] over int8 values in [-127, 127], exact in int32
+    // AVX-512 VNNI (VPDPBUSD) when available, otherwise AVX2 maddubs
+    int32_t dotProductInt8(const int8_t* a, const int8_t* b, size_t n);
+
+    // Sum of a[i] * b[i] with b in IEEE half precision, converted on the fly (F16C / AVX-512F)
+    float dotProductFp16(const float* a, const uint16_t* b, size_t n);
+
+    // Hamming distance of a packed bit vector to each of rows codes, all `words` 64-bit words long
+    // AVX-512 VPOPCNTDQ when available, otherwise POPCNT
+    void hammingDistances(const uint64_t* query, const uint64_t* codes, size_t rows, size_t words, uint32_t* distances);
+
+    // IEEE half precision conversions, round to nearest even
+    uint16_t floatToHalf(float value);
+    float halfToFloat(uint16_t half);
+
+} // namespace math
@@ -1,12 +1,69 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
+#include "Matrix.h"
 
 namespace math {
 
+    // Corpus row index with its similarity score
+    struct ScoredIndex {
+        uint32_t index;
+        float score;
+    };
+
+    // Strict "better match" order: higher score first, lower index on ties
+    inline bool betterMatch(const ScoredIndex& x, const ScoredIndex& y) {
+        return x.score > y.score || (x.score == y.score && x.index < y.index);
+    }
+
+    // Offer candidate to a heap of the best `capacity` matches, ordered by betterMatch so the worst match is
+    // in front; std::sort_heap(..., betterMatch) then lists them best first
+    inline void pushBounded(ScoredIndex* heap, size_t& size, size_t capacity, const ScoredIndex& candidate) {
+        if (size < capacity) {
+            heap[size++] = candidate;
+            std::push_heap(heap, heap + size, betterMatch);
+        } else if (betterMatch(candidate, heap[0])) {
+            std::pop_heap(heap, heap + size, betterMatch);
+            heap[size - 1] = candidate;
+            std::push_heap(heap, heap + size, betterMatch);
+        }
+    }
+
+    inline void pushBounded(std::vector<ScoredIndex>& heap, size_t capacity, const ScoredIndex& candidate) {
+        if (heap.size() < capacity) {
+            heap.push_back(candidate);
+            std::push_heap(heap.begin(), heap.end(), betterMatch);
+        } else if (betterMatch(candidate, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), betterMatch);
+            heap.back() = candidate;
+            std::push_heap(heap.begin(), heap.end(), betterMatch);
+        }
+    }
+
+    // Best matches for every query row, flat [rows, k]
+    // Each row is sorted by descending score, ties broken by lower index
+    struct TopK {
+        size_t rows = 0;
+        size_t k = 0;                        // min(requested k, corpus rows)
+        std::vector<ScoredIndex> entries;
+
+        const ScoredIndex* row(size_t i) const { return entries.data() + i * k; }
+    };
+
+    // Threads used by the matrix products and top-K searches below: 0 = all cores, 1 = calling thread only
+    // Work is split by query rows or by corpus shards depending on shape; results are identical for any count
+    void setThreadCount(size_t threads);
+    size_t threadCount();
+
     // Compute cosine similarity between two vectors
     float cosineSimilarity(const std::vector<float>& a, const std::vector<float>& b);
 
+    // Similarity of vectors that are already L2-normalized: plain dot product, no norms
+    float cosineSimilarityNormalized(const std::vector<float>& a, const std::vector<float>& b);
+
     // Compute cosine similarity matrix
     // a: [N, D], b: [M, D] -> [N, M]
     std::vector<std::vector<float>> cosineSimilarityMatrix(
@@ -17,5 +74,31 @@ namespace math {
     // Compute L2 norm of vector
     float l2Norm(const std::vector<float>& vec);
 
+    // Scale vector to unit L2 norm in place, zero vectors stay zero
+    void normalize(float* vec, size_t size);
+    void normalize(std::vector<float>& vec);
+
+    // Scale every row to unit L2 norm in place, zero rows stay zero
+    void normalizeRows(Matrix& m);
+
+    // c = a * b^T
+    // a: [N, D], b: [M, D] -> c: [N, M]
+    // Cache-blocked SGEMM: b is packed into panels that stay in L2 while rows of a stream through
+    void matmulTransposed(const MatrixView& a, const MatrixView& b, Matrix& c);
+
+    // Compute cosine similarity matrix on contiguous storage
+    // a: [N, D], b: [M, D] -> [N, M]; both inputs are normalized once, then one GEMM
+    Matrix cosineSimilarityMatrix(const MatrixView& a, const MatrixView& b);
+
+    // Top-K cosine matches of every query row in corpus without materializing the [N, M] score matrix
+    // Scores are computed in cache-sized tiles and fed into per-row bounded heaps: O(N * K) memory
+    TopK topKSimilarity(const MatrixView& queries, const MatrixView& corpus, size_t k);
+
+    // Same for inputs that are already L2-normalized (plain dot product, no copies)
+    TopK topKDotProduct(const MatrixView& queries, const MatrixView& corpus, size_t k);
+
+    // Similarity matrix of already L2-normalized inputs, no copies
+    Matrix dotProductMatrix(const MatrixView& a, const MatrixView& b);
+
 } // namespace math
 
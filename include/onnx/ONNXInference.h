@@ -20,13 +20,19 @@ namespace onnx {
         ONNXSession& operator=(const ONNXSession&) = delete;
 
         // Run inference
-        std::vector<float> run(const std::string& inputName, const std::vector<float>& input);
+        // Float input is a batch of images packed as [batchSize, 3, 224, 224]
+        std::vector<float> run(const std::string& inputName, const std::vector<float>& input, int64_t batchSize = 1);
         std::vector<float> run(const std::string& inputName, const std::vector<int32_t>& input);
+        std::vector<float> run(const std::string& inputName, const std::vector<uint8_t>& input, const std::vector<int64_t>& inputShape);
 
         // Get input/output names
         std::string getInputName(size_t index = 0) const;
         std::string getOutputName(size_t index = 0) const;
 
+        // Get input tensor description (dynamic dimensions are -1)
+        ONNXTensorElementDataType getInputElementType(size_t index = 0) const;
+        std::vector<int64_t> getInputShape(size_t index = 0) const;
+
     private:
         Ort::Session session_;
         std::vector<const char*> inputNames_;
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace pipeline {
+
+    // Blocking FIFO queue with fixed capacity
+    // push() waits while the queue is full, pop() waits while it is empty
+    template <typename T>
+    class BoundedQueue {
+    public:
+        explicit BoundedQueue(size_t capacity) : capacity_(capacity > 0 ? capacity : 1), closed_(false) {}
+
+        // Returns false if the queue was closed before the item could be added
+        bool push(T item) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notFull_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+            if (closed_) {
+                return false;
+            }
+            items_.push_back(std::move(item));
+            notEmpty_.notify_one();
+            return true;
+        }
+
+        // Returns std::nullopt once the queue is closed and drained
+        std::optional<T> pop() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notEmpty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+            if (items_.empty()) {
+                return std::nullopt;
+            }
+            T item = std::move(items_.front());
+            items_.pop_front();
+            notFull_.notify_one();
+            return item;
+        }
+
+        // Wake up all waiters; remaining items can still be popped
+        void close() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+            notEmpty_.notify_all();
+            notFull_.notify_all();
+        }
+
+    private:
+        size_t capacity_;
+        bool closed_;
+        std::deque<T> items_;
+        std::mutex mutex_;
+        std::condition_variable notEmpty_;
+        std::condition_variable notFull_;
+    };
+
+} // namespace pipeline
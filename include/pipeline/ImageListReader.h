@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+#include "ImageSource.h"
+
+namespace pipeline {
+
+    // Image files named one per line in a stream, e.g. a work list from a job scheduler or std::cin
+    // Lines are taken as the decoders ask for images, so the list is never loaded as a whole and
+    // encoding starts with the first path. Empty lines and lines starting with '#' are skipped.
+    // The calling decode thread reads the file itself; images are numbered in list order
+    class ImageListReader : public ImageSource {
+    public:
+        // input must outlive the reader
+        explicit ImageListReader(std::istream& input, size_t limit = std::numeric_limits<size_t>::max());
+
+        ImageListReader(const ImageListReader&) = delete;
+        ImageListReader& operator=(const ImageListReader&) = delete;
+
+        std::optional<EncodedImage> next() override;
+
+        // Path of an image returned by next(), as written in the list
+        std::string path(size_t index) const;
+
+    private:
+        std::istream& input_;
+        size_t limit_;
+
+        mutable std::mutex mutex_;
+        std::vector<std::string> paths_;
+        bool exhausted_;
+    };
+
+} // namespace pipeline
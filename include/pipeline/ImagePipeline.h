@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <functional>
+#include "../clip/CLIPInference.h"
+#include "ImageSource.h"
+
+namespace pipeline {
+
+    struct PipelineOptions {
+        int decodeThreads;      // 0 = hardware concurrency
+        int inferenceThreads;
+        int batchSize;
+        int queueDepth;         // max number of ready batches waiting for inference
+        int prefetchThreads;    // 0 = decoders read files themselves, otherwise file bytes are read ahead
+        size_t prefetchBytes;   // read-ahead budget: bytes read but not yet taken by a decoder
+    };
+
+    // Producer/consumer image encoder:
+    // decode workers load and preprocess images into batches and push them into a bounded queue,
+    // inference workers pop batches and run the image encoder, so decoding overlaps with inference
+    // With prefetchThreads a PrefetchReader reads files ahead and decoders work from memory
+    class ImagePipeline {
+    public:
+        // Called with the index of the image in the input list
+        using ResultCallback = std::function<void(size_t index, std::vector<float>&& embedding)>;
+        using ErrorCallback = std::function<void(size_t index, const std::string& message)>;
+
+        ImagePipeline(clip::CLIPInference& clip, const PipelineOptions& options);
+        ~ImagePipeline();
+
+        // Encode all images, blocks until done
+        // Callbacks are serialized, so they may touch shared state without locking
+        // Results arrive in completion order, not in input order
+        // With an image cache on clip, cached images are reported by decode workers without inference
+        void run(
+            const std::vector<std::filesystem::path>& imagePaths,
+            const ResultCallback& onResult,
+            const ErrorCallback& onError
+        );
+
+        // Encode all images of source (e.g. TarShardReader), decoding from memory; blocks until done
+        // Callback indices are EncodedImage::index
+        void run(ImageSource& source, const ResultCallback& onResult, const ErrorCallback& onError);
+
+    private:
+        // Decode and inference stages; images come from reader if set, otherwise decoders read imagePaths
+        void runStages(
+            const std::vector<std::filesystem::path>& imagePaths,
+            ImageSource* reader,
+            const ResultCallback& onResult,
+            const ErrorCallback& onError
+        );
+
+        clip::CLIPInference& clip_;
+        PipelineOptions options_;
+    };
+
+} // namespace pipeline
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace pipeline {
+
+    // Encoded image bytes (JPEG, PNG, ...) handed to the decoders
+    struct EncodedImage {
+        size_t index;                   // position in the source, used for result callbacks
+        std::vector<uint8_t> data;      // from utils::byteBufferPool(), released by the consumer
+        std::string error;              // non-empty if the image could not be read
+    };
+
+    // Producer of encoded images for ImagePipeline, e.g. files read ahead or members of tar shards
+    class ImageSource {
+    public:
+        virtual ~ImageSource() = default;
+
+        // Next image, blocks while none is ready; std::nullopt once the source is exhausted
+        // Must be safe to call from several decode threads
+        virtual std::optional<EncodedImage> next() = 0;
+    };
+
+} // namespace pipeline
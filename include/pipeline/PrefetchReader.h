@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ImageSource.h"
+
+namespace pipeline {
+
+    struct PrefetchOptions {
+        int threads;                // reader threads
+        size_t maxBytesInFlight;    // buffer capacity read but not yet taken by next(); one larger file is always let through
+        size_t adviseAhead;         // files past the current one to announce to the OS for readahead
+    };
+
+    // Reads whole image files ahead of the decoders so decoding works from memory and never waits on the disk
+    // Reader threads claim files in list order. Before reading a file, a reader also hints the file
+    // adviseAhead positions later with posix_fadvise(WILLNEED), so the kernel fetches it in the background.
+    // Buffers come from utils::byteBufferPool() and can be released there after decoding
+    class PrefetchReader : public ImageSource {
+    public:
+        // paths must outlive the reader
+        PrefetchReader(const std::vector<std::filesystem::path>& paths, const PrefetchOptions& options);
+
+        // Stops and joins reader threads, unread files are skipped
+        ~PrefetchReader() override;
+
+        PrefetchReader(const PrefetchReader&) = delete;
+        PrefetchReader& operator=(const PrefetchReader&) = delete;
+
+        // Next file in completion order; index is the position in paths
+        std::optional<EncodedImage> next() override;
+
+    private:
+        void readerLoop();
+
+        const std::vector<std::filesystem::path>& paths_;
+        PrefetchOptions options_;
+        std::atomic<size_t> nextIndex_;
+
+        std::mutex mutex_;
+        std::condition_variable budgetFreed_;
+        std::condition_variable fileReady_;
+        std::deque<EncodedImage> ready_;
+        size_t bytesInFlight_;
+        size_t delivered_;
+        bool stopping_;
+        std::vector<std::thread> readers_;
+    };
+
+} // namespace pipeline
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ImageSource.h"
+
+namespace pipeline {
+
+    struct TarShardOptions {
+        int threads = 1;                                        // shards read at once, each front to back
+        size_t maxBytesInFlight = size_t(64) << 20;             // buffer capacity of members read but not yet taken by next()
+        size_t limit = std::numeric_limits<size_t>::max();      // stop after this many images
+        bool sniffContent = false;                              // read members without an image extension and keep those with an image signature
+    };
+
+    // Image members of tar shards (WebDataset layout: many small files packed into large archives)
+    // Every shard is one sequential stream, so reading is bound by disk bandwidth instead of per-file metadata
+    // Non-image members (.json, .txt, ...) are skipped by name, or after reading them with sniffContent.
+    // Images are numbered in the order they are read
+    class TarShardReader : public ImageSource {
+    public:
+        explicit TarShardReader(std::vector<std::filesystem::path> shards, const TarShardOptions& options = {});
+
+        // Stops and joins reader threads
+        ~TarShardReader() override;
+
+        TarShardReader(const TarShardReader&) = delete;
+        TarShardReader& operator=(const TarShardReader&) = delete;
+
+        std::optional<EncodedImage> next() override;
+
+        // "<shard file name>/<member name>" of an image returned by next(); just the shard name for shard errors
+        std::string key(size_t index) const;
+
+    private:
+        void readerLoop();
+
+        // Queue image or error under the next index; false once stopping or the limit is reached
+        // data was already counted against the budget by the reader and is uncounted if it is dropped here
+        bool publish(std::string key, std::vector<uint8_t> data, std::string error);
+
+        std::vector<std::filesystem::path> shards_;
+        TarShardOptions options_;
+        std::atomic<size_t> nextShard_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable budgetFreed_;
+        std::condition_variable imageReady_;
+        std::deque<EncodedImage> ready_;
+        std::vector<std::string> keys_;
+        size_t bytesInFlight_;
+        int activeReaders_;
+        bool stopping_;
+        std::vector<std::thread> readers_;
+    };
+
+    // Tar files in directory (non-recursive) sorted by name, or the file itself if path is a tar file
+    std::vector<std::filesystem::path> findTarShards(const std::filesystem::path& path);
+
+} // namespace pipeline
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace store {
+
+    // Persistent key -> embedding map for skipping encoder runs across process restarts
+    //
+    // On-disk format (little-endian), version 1, append-only:
+    //   header      32 bytes: magic "CLIPKVC\0", version, dim, model key
+    //   records     {uint32 keyLength, key bytes, dim float32, uint64 hash of the preceding record bytes}
+    //
+    // The model key identifies everything that affects embeddings (encoder weights, tokenizer, normalization);
+    // a file written under another key or dimension is ignored and replaced on the next flush.
+    // A torn last record (e.g. after a crash) fails its hash and is dropped. Later records win for duplicate keys
+    //
+    // Thread-safe: lookups and inserts may come from several encoder threads
+    class EmbeddingCache {
+    public:
+        static constexpr uint32_t FORMAT_VERSION = 1;
+
+        // Reads filePath if it exists; nothing is written until flush()
+        EmbeddingCache(const std::filesystem::path& filePath, size_t dim, uint64_t modelKey);
+
+        // Flushes pending records, errors are swallowed
+        ~EmbeddingCache();
+
+        EmbeddingCache(const EmbeddingCache&) = delete;
+        EmbeddingCache& operator=(const EmbeddingCache&) = delete;
+
+        // Copy embedding for key into out (dim floats), false if not cached
+        bool get(std::string_view key, float* out) const;
+
+        // Insert or replace; the record reaches the file on flush()
+        void put(std::string_view key, const float* embedding, size_t dim);
+
+        // Append records added since the last flush, or rewrite the file if it was stale or damaged
+        void flush();
+
+        size_t size() const;
+        size_t dim() const { return dim_; }
+        const std::filesystem::path& path() const { return filePath_; }
+
+    private:
+        void readFile();
+
+        std::filesystem::path filePath_;
+        size_t dim_;
+        uint64_t modelKey_;
+
+        mutable std::mutex mutex_;
+        std::unordered_map<std::string, size_t> rows_;     // key -> row in vectors_
+        std::vector<float> vectors_;
+        std::vector<std::string> pending_;                  // keys not yet in the file
+        bool rewrite_;                                      // file missing, stale or has a damaged tail
+    };
+
+} // namespace store
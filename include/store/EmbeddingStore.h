@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../math/Matrix.h"
+
+namespace utils {
+    class MappedFile;
+}
+
+namespace store {
+
+    // Contiguous [N, D] float32 embedding matrix with a string id and optional metadata per row
+    //
+    // On-disk format (little-endian), version 1:
+    //   header      64 bytes: magic "CLIPEMB\0", version, dim, count, section offsets
+    //   vectors     count * dim float32, 64-byte aligned
+    //   entries     count * {uint64 offset, uint32 idLength, uint32 metadataLength}
+    //   strings     id bytes followed by metadata bytes for every row
+    //
+    // A store is either in memory (built with add() or load()) or memory-mapped read-only (open()),
+    // in which case rows point straight into the page cache and the file can be shared across processes
+    class EmbeddingStore {
+    public:
+        static constexpr uint32_t FORMAT_VERSION = 1;
+
+        explicit EmbeddingStore(size_t dim = 0);
+        ~EmbeddingStore();
+
+        EmbeddingStore(EmbeddingStore&&) noexcept;
+        EmbeddingStore& operator=(EmbeddingStore&&) noexcept;
+        EmbeddingStore(const EmbeddingStore&) = delete;
+        EmbeddingStore& operator=(const EmbeddingStore&) = delete;
+
+        // Append row and return its index; the first row fixes dim if it was 0
+        // Throws for memory-mapped stores
+        size_t add(std::string_view id, const float* embedding, size_t dim, std::string_view metadata = {});
+        size_t add(std::string_view id, const std::vector<float>& embedding, std::string_view metadata = {});
+
+        size_t size() const { return count_; }
+        size_t dim() const { return dim_; }
+        bool empty() const { return count_ == 0; }
+        bool isMapped() const { return mapping_ != nullptr; }
+
+        const float* row(size_t i) const { return vectorsData() + i * dim_; }
+        std::string_view id(size_t i) const;
+        std::string_view metadata(size_t i) const;
+
+        // All rows as one matrix for math::topKDotProduct and friends, no copy
+        math::MatrixView vectors() const { return { vectorsData(), count_, dim_ }; }
+
+        // Row index by id; the lookup table is built on first use
+        std::optional<size_t> find(std::string_view id) const;
+
+        // Write store to file; goes through a temporary file so readers never see a partial store
+        void save(const std::filesystem::path& filePath) const;
+
+        // Read whole file into memory, the store stays writable
+        static EmbeddingStore load(const std::filesystem::path& filePath);
+
+        // Memory-map file read-only, loading is O(1) regardless of row count
+        static EmbeddingStore open(const std::filesystem::path& filePath);
+
+    private:
+        struct Entry {
+            uint64_t offset;
+            uint32_t idLength;
+            uint32_t metadataLength;
+        };
+
+        struct IdIndex;
+
+        const float* vectorsData() const;
+        const Entry* entriesData() const;
+        const char* stringsData() const;
+
+        // Parse and validate header of a mapped file
+        void attach(std::unique_ptr<utils::MappedFile> mapping, const std::filesystem::path& filePath);
+
+        size_t dim_;
+        size_t count_;
+
+        // In-memory storage
+        math::Matrix::Storage vectors_;
+        std::vector<Entry> entries_;
+        std::string strings_;
+
+        // Memory-mapped storage
+        std::unique_ptr<utils::MappedFile> mapping_;
+        const float* mappedVectors_;
+        const Entry* mappedEntries_;
+        const char* mappedStrings_;
+
+        mutable std::unique_ptr<IdIndex> idIndex_;
+    };
+
+} // namespace store
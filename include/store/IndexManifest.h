@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace store {
+
+    class EmbeddingStore;
+
+    // State of one indexed file and the EmbeddingStore row holding its embedding
+    struct ManifestEntry {
+        static constexpr uint64_t NO_ROW = std::numeric_limits<uint64_t>::max();
+
+        std::string path;           // relative to the indexed directory, generic separators
+        uint64_t size = 0;
+        int64_t mtime = 0;          // last write time in file clock ticks
+        uint64_t contentHash = 0;   // utils::hashFile of the content
+        uint64_t row = NO_ROW;
+        bool deleted = false;       // tombstone: file is gone, row is dead until the store is compacted
+    };
+
+    // Files that need work after comparing a directory against the manifest
+    struct ManifestUpdate {
+        std::vector<std::filesystem::path> changed;     // new or modified files, to be encoded
+        size_t unchanged = 0;
+        size_t deleted = 0;                             // tombstoned by this update
+    };
+
+    // Manifest of an incrementally indexed directory, kept next to its EmbeddingStore
+    // A file is unchanged if size and mtime match; otherwise its content hash decides, so touched
+    // but identical files are not re-encoded. Rows of changed and deleted files stay in the store
+    // unreferenced until compact() drops them
+    //
+    // On-disk format (little-endian), version 1:
+    //   header      32 bytes: magic "CLIPMAN\0", version, entry count
+    //   entries     {uint64 size, int64 mtime, uint64 contentHash, uint64 row, uint32 flags, uint32 pathLength, path bytes}
+    class IndexManifest {
+    public:
+        static constexpr uint32_t FORMAT_VERSION = 1;
+
+        // Compare files under root (e.g. from utils::loadTestImages(root)) against the manifest
+        // Unchanged entries are refreshed in place; entries missing from files become tombstones
+        ManifestUpdate scan(const std::filesystem::path& root, const std::vector<std::filesystem::path>& files);
+
+        // Record the store row of a file returned in ManifestUpdate::changed after it was encoded
+        // Size, mtime and hash are the ones scan() saw, so a file edited meanwhile is picked up next scan
+        void commit(const std::filesystem::path& root, const std::filesystem::path& file, uint64_t row);
+
+        // Manifest path of a file under root, also used as its store id
+        static std::string key(const std::filesystem::path& root, const std::filesystem::path& file);
+
+        const ManifestEntry* find(std::string_view path) const;
+        const std::vector<ManifestEntry>& entries() const { return entries_; }
+
+        // Rows referenced by live entries, ascending
+        std::vector<uint64_t> liveRows() const;
+
+        // Whether every live row exists in store and carries the entry's path as id
+        // False if the store file was deleted or replaced, or a crash left store and manifest from different saves
+        bool matches(const EmbeddingStore& store) const;
+
+        // Renumber rows after the store was rewritten with liveRows() only, in that order; drops tombstones
+        void compact();
+
+        void save(const std::filesystem::path& filePath) const;
+
+        // Empty manifest if the file does not exist
+        static IndexManifest load(const std::filesystem::path& filePath);
+
+        // Manifest file kept next to an embedding store
+        static std::filesystem::path pathFor(const std::filesystem::path& storePath);
+
+    private:
+        // State of a changed file as scan() saw it, taken together so commit() cannot mix two versions
+        struct PendingFile {
+            uint64_t size;
+            int64_t mtime;
+            uint64_t contentHash;
+        };
+
+        ManifestEntry& entryFor(const std::string& path);
+
+        std::vector<ManifestEntry> entries_;
+        std::unordered_map<std::string, size_t> byPath_;
+        std::unordered_map<std::string, PendingFile> pending_;   // changed files found by scan(), until commit()
+    };
+
+} // namespace store
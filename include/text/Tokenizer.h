@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <filesystem>
@@ -10,6 +11,9 @@ namespace text {
 
     class Tokenizer {
     public:
+        // Bump when tokenize() output changes for the same vocabulary, invalidates persisted text embeddings
+        static constexpr uint32_t VERSION = 1;
+
         Tokenizer();
         ~Tokenizer();
 
@@ -20,7 +24,7 @@ namespace text {
         );
 
         // Tokenize text and pad to context length
-        // Returns [context_length] vector
+        // Returns [context_length] vector from utils::tokenBufferPool(), can be released there after inference
         std::vector<int32_t> tokenize(const std::string& text);
 
         // Tokenize multiple texts
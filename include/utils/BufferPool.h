@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace utils {
+
+    struct BufferPoolStats {
+        uint64_t acquisitions;
+        uint64_t hits;               // served from a thread cache without allocating
+        uint64_t misses;
+        uint64_t releases;
+        int64_t bytesInUse;          // acquired and not released yet
+        int64_t peakBytesInUse;
+        int64_t cachedBytes;         // parked in thread caches
+        int64_t peakCachedBytes;
+    };
+
+    // Recycles std::vector buffers of short-lived tensors and file bytes (image inputs, token inputs, batches)
+    // Buffers are kept in power-of-two size classes by capacity, and acquire() only looks in the class of the
+    // request, so a reused buffer is less than twice the requested size: a small request never pins a large tensor
+    // Every thread keeps its own small LIFO cache per class, so the common acquire/release never takes a lock
+    // Overflow goes to a shared list per class, which lets buffers flow from producer to consumer threads
+    // Buffers that are never released simply leave the pool; vectors handed out to keep should not come from it
+    template <typename T>
+    class BufferPool {
+    public:
+        static constexpr size_t SIZE_CLASSES = 64;
+        static constexpr size_t MAX_CACHED_PER_THREAD = 4;     // per size class
+        static constexpr size_t MAX_CACHED_SHARED = 16;        // per size class
+
+        // One pool per element type
+        static BufferPool& instance() {
+            static BufferPool pool;
+            return pool;
+        }
+
+        // Returns vector of exactly `size` elements, contents unspecified
+        std::vector<T> acquire(size_t size) {
+            acquisitions_.fetch_add(1, std::memory_order_relaxed);
+
+            std::vector<T> buffer;
+            const size_t sizeClass = sizeClassOf(size);
+            bool found = takeFrom(threadCache().buffers[sizeClass], size, buffer);
+            if (!found) {
+                std::lock_guard<std::mutex> lock(sharedMutex_);
+                found = takeFrom(shared_[sizeClass], size, buffer);
+            }
+
+            if (found) {
+                cachedBytes_.fetch_sub(static_cast<int64_t>(bytesOf(buffer)), std::memory_order_relaxed);
+                hits_.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                misses_.fetch_add(1, std::memory_order_relaxed);
+            }
+            buffer.resize(size);
+
+            int64_t bytes = static_cast<int64_t>(bytesOf(buffer));
+            updatePeak(peakBytesInUse_, bytesInUse_.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+            return buffer;
+        }
+
+        // Give buffer back to the calling thread's cache; the vector is left empty
+        void release(std::vector<T>&& buffer) {
+            if (buffer.capacity() == 0) {
+                return;
+            }
+            releases_.fetch_add(1, std::memory_order_relaxed);
+            bytesInUse_.fetch_sub(static_cast<int64_t>(bytesOf(buffer)), std::memory_order_relaxed);
+
+            int64_t bytes = static_cast<int64_t>(bytesOf(buffer));
+            const size_t sizeClass = sizeClassOf(buffer.capacity());
+            bool cached = false;
+            auto& cache = threadCache().buffers[sizeClass];
+            if (cache.size() < MAX_CACHED_PER_THREAD) {
+                cache.push_back(std::move(buffer));
+                cached = true;
+            } else {
+                std::lock_guard<std::mutex> lock(sharedMutex_);
+                if (shared_[sizeClass].size() < MAX_CACHED_SHARED) {
+                    shared_[sizeClass].push_back(std::move(buffer));
+                    cached = true;
+                }
+            }
+
+            if (cached) {
+                updatePeak(peakCachedBytes_, cachedBytes_.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+            }
+            buffer = std::vector<T>();
+        }
+
+        BufferPoolStats stats() const {
+            return {
+                acquisitions_.load(std::memory_order_relaxed),
+                hits_.load(std::memory_order_relaxed),
+                misses_.load(std::memory_order_relaxed),
+                releases_.load(std::memory_order_relaxed),
+                bytesInUse_.load(std::memory_order_relaxed),
+                peakBytesInUse_.load(std::memory_order_relaxed),
+                cachedBytes_.load(std::memory_order_relaxed),
+                peakCachedBytes_.load(std::memory_order_relaxed)
+            };
+        }
+
+    private:
+        using Buffers = std::vector<std::vector<T>>;
+
+        struct ThreadCache {
+            Buffers buffers[SIZE_CLASSES];
+
+            ~ThreadCache() {
+                int64_t bytes = 0;
+                for (const auto& sizeClass : buffers) {
+                    for (const auto& buffer : sizeClass) {
+                        bytes += static_cast<int64_t>(bytesOf(buffer));
+                    }
+                }
+                instance().cachedBytes_.fetch_sub(bytes, std::memory_order_relaxed);
+            }
+        };
+
+        BufferPool() = default;
+
+        static ThreadCache& threadCache() {
+            static thread_local ThreadCache cache;
+            return cache;
+        }
+
+        // floor(log2(n)); class 0 also holds empty requests
+        static size_t sizeClassOf(size_t n) {
+            size_t sizeClass = 0;
+            while (n >>= 1) {
+                ++sizeClass;
+            }
+            return sizeClass;
+        }
+
+        // Move out the most recently cached buffer of the class that can hold `size` elements
+        static bool takeFrom(Buffers& cache, size_t size, std::vector<T>& buffer) {
+            for (size_t i = cache.size(); i-- > 0;) {
+                if (cache[i].capacity() >= size) {
+                    buffer = std::move(cache[i]);
+                    cache.erase(cache.begin() + static_cast<std::ptrdiff_t>(i));
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        static uint64_t bytesOf(const std::vector<T>& buffer) {
+            return static_cast<uint64_t>(buffer.capacity()) * sizeof(T);
+        }
+
+        static void updatePeak(std::atomic<int64_t>& peak, int64_t value) {
+            int64_t current = peak.load(std::memory_order_relaxed);
+            while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+            }
+        }
+
+        std::mutex sharedMutex_;
+        Buffers shared_[SIZE_CLASSES];
+
+        std::atomic<uint64_t> acquisitions_{0};
+        std::atomic<uint64_t> hits_{0};
+        std::atomic<uint64_t> misses_{0};
+        std::atomic<uint64_t> releases_{0};
+        std::atomic<int64_t> bytesInUse_{0};
+        std::atomic<int64_t> peakBytesInUse_{0};
+        std::atomic<int64_t> cachedBytes_{0};
+        std::atomic<int64_t> peakCachedBytes_{0};
+    };
+
+    // Pools for image tensors, encoded file bytes and text encoder inputs
+    inline BufferPool<float>& floatBufferPool() { return BufferPool<float>::instance(); }
+    inline BufferPool<uint8_t>& byteBufferPool() { return BufferPool<uint8_t>::instance(); }
+    inline BufferPool<int32_t>& tokenBufferPool() { return BufferPool<int32_t>::instance(); }
+
+} // namespace utils
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace utils {
+
+    struct WalkOptions {
+        // Stop after this many files; later directories are never listed
+        size_t limit = std::numeric_limits<size_t>::max();
+        // 1 = walk on the calling thread in sorted order; more lists subdirectories in parallel, order is then arbitrary
+        size_t threads = 1;
+        // Files found but not yet taken by next() before parallel workers pause
+        size_t bufferSize = 4096;
+        // Files without an image extension are also checked by their first bytes (utils::sniffImageFormat);
+        // costs one open and read per such file
+        bool sniffContent = false;
+    };
+
+    // Lazy recursive walk yielding image files (utils::isImageFile) as they are discovered
+    // Single-threaded, every directory is listed and sorted before descending, so files come out in the same
+    // order as sorting all paths, and only the directories needed to reach `limit` are ever read.
+    // Directory symlinks are not followed, as with std::filesystem::recursive_directory_iterator
+    // On Linux directories are read with batched getdents64 and d_type, calling statx only where the
+    // filesystem leaves the type unknown; elsewhere std::filesystem::directory_iterator is used
+    class DirectoryWalker {
+    public:
+        // Subdirectory or image file found while listing a directory
+        struct Entry {
+            std::filesystem::path path;
+            bool directory;
+        };
+
+        explicit DirectoryWalker(const std::filesystem::path& root, const WalkOptions& options = {});
+
+        // Stops and joins parallel workers
+        ~DirectoryWalker();
+
+        DirectoryWalker(const DirectoryWalker&) = delete;
+        DirectoryWalker& operator=(const DirectoryWalker&) = delete;
+
+        // Next image file, std::nullopt when the tree is exhausted or the limit was reached
+        // Rethrows filesystem errors from the walk
+        std::optional<std::filesystem::path> next();
+
+    private:
+        struct Frame {
+            std::vector<Entry> entries;
+            size_t next = 0;
+        };
+
+        std::optional<std::filesystem::path> nextSequential();
+        std::optional<std::filesystem::path> nextParallel();
+        void workerLoop();
+        void stop();
+
+        WalkOptions options_;
+        size_t returned_;
+
+        // Sequential walk: one frame per open directory
+        std::vector<Frame> stack_;
+
+        // Parallel walk: shared queue of directories still to list, bounded queue of found files
+        std::mutex mutex_;
+        std::condition_variable workAvailable_;
+        std::condition_variable resultsChanged_;
+        std::deque<std::filesystem::path> pendingDirs_;
+        std::deque<std::filesystem::path> results_;
+        size_t busyWorkers_;
+        bool stopping_;
+        std::exception_ptr error_;
+        std::vector<std::thread> workers_;
+    };
+
+} // namespace utils
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace utils {
@@ -9,14 +11,61 @@ namespace utils {
     // Load text classes from file, ignoring empty lines and comments starting with '#'
     std::vector<std::string> loadTextClasses(const std::filesystem::path& filePath);
 
-    // Recursively find image files in directory
+    // Recursively find image files in directory, sorted
+    // Stops walking once maxImages files are found (utils::DirectoryWalker), so a small limit stays fast on huge trees
+    // With walkThreads > 1 subdirectories are listed in parallel; if the limit cuts the walk short,
+    // the result is the first maxImages files found rather than the first in sorted order
     std::vector<std::filesystem::path> loadTestImages(
         const std::filesystem::path& dirPath,
-        int maxImages = 10
+        int maxImages = 10,
+        int walkThreads = 1,
+        bool sniffContent = false
     );
 
-    // Check if file has image extension
-    bool isImageFile(const std::filesystem::path& filePath);
+    // Read all bytes from an open file descriptor (file, pipe or socket) until EOF
+    // The descriptor is not closed
+    std::vector<uint8_t> readFileDescriptor(int fd);
+
+    enum class ImageFormat {
+        Unknown,
+        Jpeg,
+        Png,
+        WebP,
+        Tiff,
+        Bmp,
+        Avif,
+        JpegXl
+    };
+
+    const char* imageFormatName(ImageFormat format);
+
+    // Format by file name extension, case-insensitive; Unknown without a known extension
+    ImageFormat imageFormatFromName(std::string_view fileName);
+    ImageFormat imageFormatFromName(std::wstring_view fileName);     // native Windows path
+
+    // Leading bytes sniffImageFormat() needs: every signature plus the first AVIF compatible brands
+    inline constexpr size_t IMAGE_SNIFF_BYTES = 64;
+
+    // Format by the signature at the start of the file content, whatever the file is called
+    ImageFormat sniffImageFormat(const uint8_t* data, size_t size);
+
+    // Format by the first IMAGE_SNIFF_BYTES of a file; Unknown if it cannot be read
+    ImageFormat sniffImageFile(const std::filesystem::path& filePath);
+
+    // Whether the linked OpenCV decodes format; AVIF and JPEG XL need a build with
+    // CLIP_HAVE_AVIF / CLIP_HAVE_JXL defined (OpenCV 4.9+ with libavif, 4.11+ with libjxl)
+    bool isDecodableImageFormat(ImageFormat format);
+
+    // ASCII case-insensitive comparison, e.g. of file extensions
+    bool equalsIgnoreCase(std::string_view a, std::string_view b);
+    bool equalsIgnoreCase(std::wstring_view a, std::string_view b);  // b ASCII, e.g. an extension constant
+
+    // Check if file name has the extension of a decodable image format; no allocation
+    bool isImageFileName(std::string_view fileName);
+
+    // Check if file has the extension of a decodable image format
+    // With sniffContent, a file without a known image extension is recognized by its first bytes instead
+    bool isImageFile(const std::filesystem::path& filePath, bool sniffContent = false);
 
 } // namespace utils
 
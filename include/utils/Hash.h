@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+namespace utils {
+
+    // 64-bit non-cryptographic hash (XXH64), several GB/s per core
+    // Stable across runs and platforms, so it can key data written to disk
+    uint64_t hash64(const void* data, size_t size, uint64_t seed = 0);
+
+    inline uint64_t hash64(std::string_view text, uint64_t seed = 0) {
+        return hash64(text.data(), text.size(), seed);
+    }
+
+    struct Hash128 {
+        uint64_t low;       // equal to hash64() with the same seed
+        uint64_t high;
+    };
+
+    // 128-bit hash in a single pass over the data: the XXH64 lanes are merged a second time in another
+    // order, so the high word costs only the tail and final mixing, not a second read of the input
+    Hash128 hash128(const void* data, size_t size, uint64_t seed = 0);
+
+    // Hash of the whole file content, read through a memory mapping
+    uint64_t hashFile(const std::filesystem::path& filePath, uint64_t seed = 0);
+
+    // Mix value into an accumulated hash, order-dependent
+    inline uint64_t hashCombine(uint64_t hash, uint64_t value) {
+        return hash64(&value, sizeof(value), hash);
+    }
+
+} // namespace utils
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <fstream>
+#endif
+
+namespace utils {
+
+    // File opened for one whole sequential read into a caller buffer, e.g. a pooled one
+    // Cheaper than MappedFile for a file read once; the handle is closed by the destructor
+    class InputFile {
+    public:
+        explicit InputFile(const std::filesystem::path& filePath);
+        ~InputFile();
+
+        InputFile(const InputFile&) = delete;
+        InputFile& operator=(const InputFile&) = delete;
+
+        size_t size() const { return size_; }
+
+        // Read the whole file into out, which holds at least size() bytes
+        void readAll(uint8_t* out);
+
+    private:
+        std::filesystem::path path_;
+        size_t size_;
+#ifdef _WIN32
+        std::ifstream stream_;
+#else
+        int fd_;
+#endif
+    };
+
+} // namespace utils
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace utils {
+
+    // Read-only memory mapping of a whole file
+    // Pages come from the OS page cache, so processes mapping the same file share them
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::filesystem::path& filePath);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const uint8_t* data() const { return data_; }
+        size_t size() const { return size_; }
+
+    private:
+        const uint8_t* data_;
+        size_t size_;
+#ifdef _WIN32
+        void* fileHandle_;
+        void* mappingHandle_;
+#else
+        int fd_;
+#endif
+    };
+
+} // namespace utils
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace utils {
+
+    // Sequential reader of regular file members of a tar archive (POSIX ustar, GNU long names, pax path records)
+    // Reads front to back through a large stream buffer, so a shard costs one open and streaming reads
+    class TarReader {
+    public:
+        explicit TarReader(const std::filesystem::path& tarPath);
+
+        TarReader(const TarReader&) = delete;
+        TarReader& operator=(const TarReader&) = delete;
+
+        // Advance to the next regular file member; false at the end of the archive
+        // Throws on a truncated or malformed archive, including a member larger than what is left of the file
+        bool nextMember();
+
+        // Name and size of the current member
+        const std::string& name() const { return name_; }
+        uint64_t size() const { return size_; }
+
+        // Read current member content into out (resized to size()); skipped if not called before nextMember()
+        void read(std::vector<uint8_t>& out);
+
+        const std::filesystem::path& path() const { return path_; }
+
+    private:
+        // Skip unread content and padding of the current member
+        void skipRemainder();
+
+        void readExact(char* out, size_t size);
+
+        // Bytes of the archive after the current stream position
+        uint64_t bytesLeft();
+
+        std::filesystem::path path_;
+        std::ifstream stream_;
+        std::vector<char> streamBuffer_;
+        uint64_t fileSize_;
+        std::string name_;
+        uint64_t size_;
+        uint64_t remaining_;        // content bytes plus padding left before the next header
+    };
+
+} // namespace utils
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace utils {
+
+    // Fixed set of worker threads for data-parallel loops
+    // parallelFor() hands out task indices through a shared counter and the calling thread works too,
+    // so a pool of N workers runs N + 1 tasks at once. Calls from inside a task run inline instead of deadlocking
+    class ThreadPool {
+    public:
+        // 0 = hardware concurrency - 1 workers (the caller is the remaining thread)
+        explicit ThreadPool(size_t workers = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Threads that can run tasks at once, including the caller
+        size_t concurrency() const { return workers_.size() + 1; }
+
+        // Run task(i) for every i in [0, tasks) and wait for all of them
+        // The first exception thrown by a task is rethrown here after the remaining tasks finished
+        void parallelFor(size_t tasks, const std::function<void(size_t)>& task);
+
+    private:
+        void workerLoop();
+
+        // Claim and run tasks of the current job until none are left
+        void runTasks();
+
+        std::vector<std::thread> workers_;
+
+        std::mutex submitMutex_;            // one job at a time
+        std::mutex mutex_;
+        std::condition_variable jobReady_;
+        std::condition_variable jobDone_;
+
+        const std::function<void(size_t)>* task_;
+        size_t taskCount_;
+        size_t nextTask_;
+        size_t pendingTasks_;
+        uint64_t generation_;
+        bool stopping_;
+        std::exception_ptr error_;
+    };
+
+    // Process-wide pool shared by the math routines
+    ThreadPool& defaultThreadPool();
+
+} // namespace utils
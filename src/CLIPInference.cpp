@@ -1,11 +1,22 @@
 #include "../include/clip/CLIPInference.h"
 #include "../include/config/Config.h"
+#include "../include/utils/BufferPool.h"
+#include "../include/math/Similarity.h"
+#include "../include/utils/Hash.h"
+#include "../include/utils/MappedFile.h"
 #include <stdexcept>
+#include <algorithm>
+#include <iterator>
 
 namespace clip {
 
-    CLIPInference::CLIPInference(const std::filesystem::path& modelsDir)
-        : env_(ORT_LOGGING_LEVEL_WARNING, "CLIPInference") {
+    CLIPInference::CLIPInference(const std::filesystem::path& modelsDir, bool normalizeEmbeddings)
+        : env_(ORT_LOGGING_LEVEL_WARNING, "CLIPInference"),
+          normalizeEmbeddings_(normalizeEmbeddings),
+          imageInputUint8_(false),
+          imageBatchDynamic_(false),
+          imageInputLayout_(image::TensorLayout::NCHW),
+          modelsDir_(modelsDir) {
 
         // Load models
         auto imageModelPath = modelsDir / config::IMAGE_ENCODER_MODEL;
@@ -14,6 +25,17 @@ namespace clip {
         imageSession_ = std::make_unique<onnx::ONNXSession>(env_, imageModelPath);
         textSession_ = std::make_unique<onnx::ONNXSession>(env_, textModelPath);
 
+        // Detect image encoder with folded normalization: uint8 input, NCHW or NHWC
+        std::vector<int64_t> imageInputShape = imageSession_->getInputShape(0);
+        if (imageSession_->getInputElementType(0) == ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8) {
+            imageInputUint8_ = true;
+            if (imageInputShape.size() == 4 && imageInputShape[3] == config::IMAGE_CHANNELS) {
+                imageInputLayout_ = image::TensorLayout::NHWC;
+            }
+        }
+        // Only a symbolic batch dimension (-1) takes any batch size; a fixed one, even above 1, does not
+        imageBatchDynamic_ = !imageInputShape.empty() && imageInputShape[0] < 0;
+
         // Initialize tokenizer
         auto encoderJsonPath = modelsDir / config::TOKENIZER_ENCODER_JSON;
         auto bpeVocabPath = modelsDir / config::BPE_VOCAB_FILE;
@@ -28,51 +50,292 @@ namespace clip {
     CLIPInference::~CLIPInference() = default;
 
     std::vector<float> CLIPInference::encodeImage(const std::filesystem::path& imagePath) {
+        // Cache keys are taken from the file bytes, so map the file and decode from memory
+        if (imageCache_) {
+            utils::MappedFile file(imagePath);
+            return encodeImage(file.data(), file.size());
+        }
+
         // Preprocess image
+        if (imageInputUint8_) {
+            std::vector<uint8_t> imageTensor = preprocessImageUint8(imagePath);
+            std::vector<float> embedding = std::move(encodeImageBatch(imageTensor, 1).front());
+            utils::byteBufferPool().release(std::move(imageTensor));
+            return embedding;
+        }
         std::vector<float> imageTensor = imageProcessor_->preprocessImage(imagePath);
 
         // Run image encoder
         std::string inputName = imageSession_->getInputName(0);
-        return imageSession_->run(inputName, imageTensor);
+        std::vector<float> embedding = imageSession_->run(inputName, imageTensor);
+        utils::floatBufferPool().release(std::move(imageTensor));
+        finishEmbedding(embedding);
+        return embedding;
+    }
+
+    std::vector<float> CLIPInference::encodeImage(const uint8_t* data, size_t size) {
+        if (!imageCache_) {
+            return encodeImageBytes(data, size);
+        }
+
+        std::string key = imageContentKey(data, size);
+        std::vector<float> embedding;
+        if (findCachedImage(key, embedding)) {
+            return embedding;
+        }
+        embedding = encodeImageBytes(data, size);
+        cacheImage(key, embedding);
+        return embedding;
+    }
+
+    std::vector<float> CLIPInference::encodeImageBytes(const uint8_t* data, size_t size) {
+        // Decode and preprocess straight from memory
+        if (imageInputUint8_) {
+            std::vector<uint8_t> imageTensor = imageProcessor_->preprocessImageUint8(data, size, imageInputLayout_);
+            std::vector<float> embedding = std::move(encodeImageBatch(imageTensor, 1).front());
+            utils::byteBufferPool().release(std::move(imageTensor));
+            return embedding;
+        }
+        std::vector<float> imageTensor = imageProcessor_->preprocessImage(data, size);
+
+        // Run image encoder
+        std::string inputName = imageSession_->getInputName(0);
+        std::vector<float> embedding = imageSession_->run(inputName, imageTensor);
+        utils::floatBufferPool().release(std::move(imageTensor));
+        finishEmbedding(embedding);
+        return embedding;
+    }
+
+    std::vector<float> CLIPInference::preprocessImage(const std::filesystem::path& imagePath) const {
+        return imageProcessor_->preprocessImage(imagePath);
+    }
+
+    std::vector<float> CLIPInference::preprocessImage(const uint8_t* data, size_t size) const {
+        return imageProcessor_->preprocessImage(data, size);
+    }
+
+    std::vector<uint8_t> CLIPInference::preprocessImageUint8(const std::filesystem::path& imagePath) const {
+        return imageProcessor_->preprocessImageUint8(imagePath, imageInputLayout_);
+    }
+
+    std::vector<uint8_t> CLIPInference::preprocessImageUint8(const uint8_t* data, size_t size) const {
+        return imageProcessor_->preprocessImageUint8(data, size, imageInputLayout_);
+    }
+
+    void CLIPInference::setImageCache(const std::filesystem::path& cacheFile) {
+        // Everything that changes image embeddings goes into the model key
+        const float preprocessing[] = {
+            static_cast<float>(config::IMAGE_SIZE),
+            config::IMAGE_MEAN_R, config::IMAGE_MEAN_G, config::IMAGE_MEAN_B,
+            config::IMAGE_STD_R, config::IMAGE_STD_G, config::IMAGE_STD_B
+        };
+        uint64_t modelKey = utils::hashFile(modelsDir_ / config::IMAGE_ENCODER_MODEL);
+        modelKey = utils::hashCombine(modelKey, utils::hash64(preprocessing, sizeof(preprocessing)));
+        modelKey = utils::hashCombine(modelKey, image::ImageProcessor::VERSION);
+        modelKey = utils::hashCombine(modelKey, normalizeEmbeddings_ ? 1 : 0);
+        modelKey = utils::hashCombine(modelKey, IMAGE_KEY_VERSION);
+
+        imageCache_ = std::make_unique<store::EmbeddingCache>(cacheFile, config::EMBEDDING_DIM, modelKey);
+    }
+
+    std::string CLIPInference::imageContentKey(const uint8_t* data, size_t size) {
+        // 128 bits from one pass over the bytes; accidental collisions are negligible for any corpus
+        // whose cache fits in memory (EmbeddingCache keeps every record loaded)
+        const utils::Hash128 hash = utils::hash128(data, size);
+        const uint64_t key[3] = { hash.low, hash.high, static_cast<uint64_t>(size) };
+        return std::string(reinterpret_cast<const char*>(key), sizeof(key));
+    }
+
+    bool CLIPInference::findCachedImage(const std::string& key, std::vector<float>& embedding) const {
+        if (!imageCache_) {
+            return false;
+        }
+        embedding.resize(imageCache_->dim());
+        return imageCache_->get(key, embedding.data());
+    }
+
+    void CLIPInference::cacheImage(const std::string& key, const std::vector<float>& embedding) {
+        if (imageCache_ && embedding.size() == imageCache_->dim()) {
+            imageCache_->put(key, embedding.data(), embedding.size());
+        }
+    }
+
+    void CLIPInference::flushImageCache() {
+        if (imageCache_) {
+            imageCache_->flush();
+        }
+    }
+
+    std::vector<std::vector<float>> CLIPInference::encodeImageBatch(const std::vector<float>& batchTensor, size_t batchSize) {
+        // Run image encoder on the whole batch
+        std::string inputName = imageSession_->getInputName(0);
+        std::vector<float> output = imageSession_->run(inputName, batchTensor, static_cast<int64_t>(batchSize));
+        return splitBatchOutput(output, batchSize);
+    }
+
+    std::vector<std::vector<float>> CLIPInference::encodeImageBatch(const std::vector<uint8_t>& batchTensor, size_t batchSize) {
+        std::vector<int64_t> shape = { static_cast<int64_t>(batchSize), config::IMAGE_CHANNELS, config::IMAGE_SIZE, config::IMAGE_SIZE };
+        if (imageInputLayout_ == image::TensorLayout::NHWC) {
+            shape = { static_cast<int64_t>(batchSize), config::IMAGE_SIZE, config::IMAGE_SIZE, config::IMAGE_CHANNELS };
+        }
+
+        // Run image encoder on the whole batch
+        std::string inputName = imageSession_->getInputName(0);
+        std::vector<float> output = imageSession_->run(inputName, batchTensor, shape);
+        return splitBatchOutput(output, batchSize);
+    }
+
+    TiledEmbedding CLIPInference::encodeImageTiled(const std::filesystem::path& imagePath, const image::TileOptions& options) {
+        TiledEmbedding result;
+        std::vector<std::vector<float>> embeddings;
+
+        // Decode once, pack global view + tiles
+        if (imageInputUint8_) {
+            std::vector<uint8_t> batch = imageProcessor_->preprocessImageTiledUint8(imagePath, options, imageInputLayout_, result.tileRects);
+            const size_t views = result.tileRects.size() + 1;
+            if (imageBatchDynamic_) {
+                embeddings = encodeImageBatch(batch, views);
+            } else {
+                const size_t viewSize = batch.size() / views;
+                std::vector<uint8_t> view = utils::byteBufferPool().acquire(viewSize);
+                for (size_t i = 0; i < views; ++i) {
+                    std::copy(batch.begin() + i * viewSize, batch.begin() + (i + 1) * viewSize, view.begin());
+                    embeddings.push_back(std::move(encodeImageBatch(view, 1).front()));
+                }
+                utils::byteBufferPool().release(std::move(view));
+            }
+            utils::byteBufferPool().release(std::move(batch));
+        } else {
+            std::vector<float> batch = imageProcessor_->preprocessImageTiled(imagePath, options, result.tileRects);
+            const size_t views = result.tileRects.size() + 1;
+            if (imageBatchDynamic_) {
+                embeddings = encodeImageBatch(batch, views);
+            } else {
+                const size_t viewSize = batch.size() / views;
+                std::vector<float> view = utils::floatBufferPool().acquire(viewSize);
+                for (size_t i = 0; i < views; ++i) {
+                    std::copy(batch.begin() + i * viewSize, batch.begin() + (i + 1) * viewSize, view.begin());
+                    embeddings.push_back(std::move(encodeImageBatch(view, 1).front()));
+                }
+                utils::floatBufferPool().release(std::move(view));
+            }
+            utils::floatBufferPool().release(std::move(batch));
+        }
+
+        // Pool normalized views so every view has equal weight
+        result.pooled.assign(embeddings.front().size(), 0.0f);
+        for (const auto& embedding : embeddings) {
+            float norm = normalizeEmbeddings_ ? 1.0f : math::l2Norm(embedding);
+            if (norm > 0.0f) {
+                for (size_t j = 0; j < embedding.size(); ++j) {
+                    result.pooled[j] += embedding[j] / norm;
+                }
+            }
+        }
+        for (float& v : result.pooled) {
+            v /= static_cast<float>(embeddings.size());
+        }
+        finishEmbedding(result.pooled);
+
+        result.global = std::move(embeddings.front());
+        result.tiles.assign(std::make_move_iterator(embeddings.begin() + 1), std::make_move_iterator(embeddings.end()));
+        return result;
+    }
+
+    std::vector<std::vector<float>> CLIPInference::splitBatchOutput(const std::vector<float>& output, size_t batchSize) const {
+        if (batchSize == 0 || output.size() % batchSize != 0) {
+            throw std::runtime_error("Unexpected image encoder output size");
+        }
+
+        const size_t dim = output.size() / batchSize;
+        std::vector<std::vector<float>> embeddings;
+        embeddings.reserve(batchSize);
+        for (size_t i = 0; i < batchSize; ++i) {
+            embeddings.emplace_back(output.begin() + i * dim, output.begin() + (i + 1) * dim);
+            finishEmbedding(embeddings.back());
+        }
+
+        return embeddings;
+    }
+
+    void CLIPInference::finishEmbedding(std::vector<float>& embedding) const {
+        if (normalizeEmbeddings_) {
+            math::normalize(embedding);
+        }
+    }
+
+    void CLIPInference::setTextCache(const std::filesystem::path& cacheFile) {
+        // Everything that changes text embeddings goes into the model key
+        uint64_t modelKey = utils::hashFile(modelsDir_ / config::TEXT_ENCODER_MODEL);
+        modelKey = utils::hashCombine(modelKey, utils::hashFile(modelsDir_ / config::TOKENIZER_ENCODER_JSON));
+        modelKey = utils::hashCombine(modelKey, utils::hashFile(modelsDir_ / config::BPE_VOCAB_FILE));
+        modelKey = utils::hashCombine(modelKey, text::Tokenizer::VERSION);
+        modelKey = utils::hashCombine(modelKey, config::CONTEXT_LENGTH);
+        modelKey = utils::hashCombine(modelKey, normalizeEmbeddings_ ? 1 : 0);
+
+        textCache_ = std::make_unique<store::EmbeddingCache>(cacheFile, config::EMBEDDING_DIM, modelKey);
     }
 
     std::vector<float> CLIPInference::encodeText(const std::string& text) {
+        if (textCache_) {
+            std::vector<float> embedding(textCache_->dim());
+            if (textCache_->get(text, embedding.data())) {
+                return embedding;
+            }
+        }
+
         // Tokenize text
         std::vector<int32_t> tokens = tokenizer_->tokenize(text);
 
         // Run text encoder
         std::string inputName = textSession_->getInputName(0);
-        return textSession_->run(inputName, tokens);
+        std::vector<float> embedding = textSession_->run(inputName, tokens);
+        utils::tokenBufferPool().release(std::move(tokens));
+        finishEmbedding(embedding);
+
+        if (textCache_ && embedding.size() == textCache_->dim()) {
+            textCache_->put(text, embedding.data(), embedding.size());
+        }
+        return embedding;
     }
 
-    std::vector<std::vector<float>> CLIPInference::encodeTexts(const std::vector<std::string>& texts) {
-        // Check if we need to recompute
-        bool needsRecompute = false;
-        if (cachedTexts_.size() != texts.size()) {
-            needsRecompute = true;
-        } else {
-            for (size_t i = 0; i < texts.size(); ++i) {
-                if (cachedTexts_[i] != texts[i]) {
-                    needsRecompute = true;
-                    break;
-                }
+    math::MatrixView CLIPInference::encodeTexts(const std::vector<std::string>& texts) {
+        // Look up or fill the slot of every prompt
+        std::vector<size_t> rows(texts.size());
+        bool encoded = false;
+        for (size_t i = 0; i < texts.size(); ++i) {
+            auto it = textSlots_.find(texts[i]);
+            if (it == textSlots_.end()) {
+                std::vector<float> embedding = encodeText(texts[i]);
+                textEmbeddings_.appendRow(embedding.data(), embedding.size());
+                it = textSlots_.emplace(texts[i], textEmbeddings_.rows() - 1).first;
+                encoded = true;
             }
+            rows[i] = it->second;
         }
 
-        if (!needsRecompute) {
-            return cachedTextEmbeddings_;
+        if (encoded && textCache_) {
+            textCache_->flush();
+        }
+        if (texts.empty()) {
+            return {};
         }
 
-        // Compute embeddings
-        cachedTexts_ = texts;
-        cachedTextEmbeddings_.clear();
-        cachedTextEmbeddings_.reserve(texts.size());
-
-        for (const auto& text : texts) {
-            cachedTextEmbeddings_.push_back(encodeText(text));
+        // Usual case, the same list again: slots are already in input order
+        bool contiguous = true;
+        for (size_t i = 1; i < rows.size() && contiguous; ++i) {
+            contiguous = rows[i] == rows[0] + i;
+        }
+        const size_t dim = textEmbeddings_.cols();
+        if (contiguous) {
+            return { textEmbeddings_.row(rows[0]), rows.size(), dim };
         }
 
-        return cachedTextEmbeddings_;
+        textBatch_ = math::Matrix(rows.size(), dim);
+        for (size_t i = 0; i < rows.size(); ++i) {
+            std::copy_n(textEmbeddings_.row(rows[i]), dim, textBatch_.row(i));
+        }
+        return textBatch_.view();
     }
 
 } // namespace clip
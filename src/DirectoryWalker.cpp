@@ -0,0 +1,321 @@
+#include "../include/utils/DirectoryWalker.h"
+#include "../include/utils/FileUtils.h"
+#include <algorithm>
+#include <system_error>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstdint>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace utils {
+
+    namespace {
+
+#ifdef __linux__
+
+        // Raw getdents64 record; glibc has no wrapper before 2.30
+        struct LinuxDirent64 {
+            uint64_t d_ino;
+            int64_t d_off;
+            unsigned short d_reclen;
+            unsigned char d_type;
+            char d_name[1];
+        };
+
+        // Large buffer: one syscall returns hundreds of entries, which matters on network filesystems
+        constexpr size_t GETDENTS_BUFFER_SIZE = 256 * 1024;
+
+        // File type of name inside dirFd; follow = resolve symlinks
+        // statx asks for the type only, and AT_STATX_DONT_SYNC lets NFS answer from its attribute cache
+        unsigned char statType(int dirFd, const char* name, bool follow) {
+#ifdef STATX_TYPE
+            struct statx st;
+            int flags = AT_STATX_DONT_SYNC | (follow ? 0 : AT_SYMLINK_NOFOLLOW);
+            if (::statx(dirFd, name, flags, STATX_TYPE, &st) != 0) {
+                return DT_UNKNOWN;
+            }
+            const mode_t mode = st.stx_mode;
+#else
+            struct stat st;
+            if (::fstatat(dirFd, name, &st, follow ? 0 : AT_SYMLINK_NOFOLLOW) != 0) {
+                return DT_UNKNOWN;
+            }
+            const mode_t mode = st.st_mode;
+#endif
+            if (S_ISDIR(mode)) {
+                return DT_DIR;
+            }
+            if (S_ISREG(mode)) {
+                return DT_REG;
+            }
+            return S_ISLNK(mode) ? DT_LNK : DT_UNKNOWN;
+        }
+
+        // Image format by the first bytes of name inside dirFd, Unknown if it cannot be read
+        ImageFormat sniffAt(int dirFd, const char* name) {
+            int fd = ::openat(dirFd, name, O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                return ImageFormat::Unknown;
+            }
+            uint8_t head[IMAGE_SNIFF_BYTES];
+            ssize_t bytes;
+            do {
+                bytes = ::read(fd, head, sizeof(head));
+            } while (bytes < 0 && errno == EINTR);
+            ::close(fd);
+            return bytes > 0 ? sniffImageFormat(head, static_cast<size_t>(bytes)) : ImageFormat::Unknown;
+        }
+
+        // List directory with batched getdents64; types come from d_type, stat only where the filesystem
+        // does not fill it in or for symlinks with an image name (a link to an image counts as an image)
+        std::vector<DirectoryWalker::Entry> readDirectory(const std::filesystem::path& dirPath, bool sniffContent) {
+            int dirFd = ::open(dirPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (dirFd < 0) {
+                throw std::filesystem::filesystem_error("Failed to open directory", dirPath,
+                                                        std::error_code(errno, std::generic_category()));
+            }
+
+            std::vector<DirectoryWalker::Entry> entries;
+            std::vector<char> buffer(GETDENTS_BUFFER_SIZE);
+            while (true) {
+                long bytes = ::syscall(SYS_getdents64, dirFd, buffer.data(), buffer.size());
+                if (bytes < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    std::error_code error(errno, std::generic_category());
+                    ::close(dirFd);
+                    throw std::filesystem::filesystem_error("Failed to read directory", dirPath, error);
+                }
+                if (bytes == 0) {
+                    break;
+                }
+
+                for (long offset = 0; offset < bytes;) {
+                    const auto* record = reinterpret_cast<const LinuxDirent64*>(buffer.data() + offset);
+                    offset += record->d_reclen;
+
+                    const char* name = record->d_name;
+                    if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+                        continue;
+                    }
+
+                    unsigned char type = record->d_type;
+                    if (type == DT_UNKNOWN) {
+                        type = statType(dirFd, name, false);
+                    }
+                    if (type == DT_DIR) {
+                        entries.push_back({ dirPath / name, true });
+                        continue;
+                    }
+                    if (type != DT_REG && type != DT_LNK) {
+                        continue;
+                    }
+
+                    // Checked on the raw name, so no path is built for the non-image files
+                    // Only names without a known image extension are sniffed, and only when asked to
+                    const ImageFormat byName = imageFormatFromName(name);
+                    if (byName != ImageFormat::Unknown ? !isDecodableImageFormat(byName) : !sniffContent) {
+                        continue;
+                    }
+                    if (type == DT_LNK && statType(dirFd, name, true) != DT_REG) {
+                        continue;
+                    }
+                    if (byName == ImageFormat::Unknown && !isDecodableImageFormat(sniffAt(dirFd, name))) {
+                        continue;
+                    }
+                    entries.push_back({ dirPath / name, false });
+                }
+            }
+
+            ::close(dirFd);
+            return entries;
+        }
+
+#else
+
+        std::vector<DirectoryWalker::Entry> readDirectory(const std::filesystem::path& dirPath, bool sniffContent) {
+            std::vector<DirectoryWalker::Entry> entries;
+            for (const auto& entry : std::filesystem::directory_iterator(dirPath)) {
+                // Real directories only, directory symlinks are not followed
+                if (entry.is_directory() && !entry.is_symlink()) {
+                    entries.push_back({ entry.path(), true });
+                } else if (entry.is_regular_file() && isImageFile(entry.path(), sniffContent)) {
+                    entries.push_back({ entry.path(), false });
+                }
+            }
+            return entries;
+        }
+
+#endif
+
+        // Subdirectories and image files of one directory, sorted by path
+        std::vector<DirectoryWalker::Entry> listDirectorySorted(const std::filesystem::path& dirPath, bool sniffContent) {
+            std::vector<DirectoryWalker::Entry> entries = readDirectory(dirPath, sniffContent);
+            std::sort(entries.begin(), entries.end(),
+                [](const auto& a, const auto& b) { return a.path < b.path; });
+            return entries;
+        }
+
+    } // namespace
+
+    DirectoryWalker::DirectoryWalker(const std::filesystem::path& root, const WalkOptions& options)
+        : options_(options), returned_(0), busyWorkers_(0), stopping_(false) {
+        options_.threads = std::max<size_t>(options_.threads, 1);
+        options_.bufferSize = std::max<size_t>(options_.bufferSize, 1);
+
+        if (options_.limit == 0) {
+            return;
+        }
+
+        if (options_.threads == 1) {
+            stack_.push_back({ listDirectorySorted(root, options_.sniffContent), 0 });
+            return;
+        }
+
+        pendingDirs_.push_back(root);
+        workers_.reserve(options_.threads);
+        for (size_t i = 0; i < options_.threads; ++i) {
+            workers_.emplace_back(&DirectoryWalker::workerLoop, this);
+        }
+    }
+
+    DirectoryWalker::~DirectoryWalker() {
+        stop();
+    }
+
+    std::optional<std::filesystem::path> DirectoryWalker::next() {
+        if (returned_ >= options_.limit) {
+            stop();
+            return std::nullopt;
+        }
+
+        std::optional<std::filesystem::path> path = workers_.empty() ? nextSequential() : nextParallel();
+        if (path) {
+            ++returned_;
+        }
+        return path;
+    }
+
+    std::optional<std::filesystem::path> DirectoryWalker::nextSequential() {
+        // Depth-first over sorted listings: pre-order matches lexicographic path order
+        while (!stack_.empty()) {
+            Frame& frame = stack_.back();
+            if (frame.next == frame.entries.size()) {
+                stack_.pop_back();
+                continue;
+            }
+
+            Entry& entry = frame.entries[frame.next++];
+            if (!entry.directory) {
+                return std::move(entry.path);
+            }
+            std::vector<Entry> entries = listDirectorySorted(entry.path, options_.sniffContent);
+            stack_.push_back({ std::move(entries), 0 });
+        }
+        return std::nullopt;
+    }
+
+    std::optional<std::filesystem::path> DirectoryWalker::nextParallel() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        resultsChanged_.wait(lock, [this] {
+            return !results_.empty() || error_ || (pendingDirs_.empty() && busyWorkers_ == 0);
+        });
+
+        if (error_) {
+            std::exception_ptr error = error_;
+            lock.unlock();
+            stop();
+            std::rethrow_exception(error);
+        }
+        if (results_.empty()) {
+            return std::nullopt;
+        }
+
+        std::filesystem::path path = std::move(results_.front());
+        results_.pop_front();
+        resultsChanged_.notify_all();
+        return path;
+    }
+
+    void DirectoryWalker::workerLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            workAvailable_.wait(lock, [this] {
+                return stopping_ || !pendingDirs_.empty() || busyWorkers_ == 0;
+            });
+            if (stopping_ || pendingDirs_.empty()) {
+                // Nothing queued and nobody listing: the walk is complete
+                workAvailable_.notify_all();
+                resultsChanged_.notify_all();
+                return;
+            }
+
+            std::filesystem::path dirPath = std::move(pendingDirs_.front());
+            pendingDirs_.pop_front();
+            ++busyWorkers_;
+            lock.unlock();
+
+            std::vector<std::filesystem::path> subdirs;
+            std::vector<std::filesystem::path> files;
+            std::exception_ptr error;
+            try {
+                for (auto& entry : readDirectory(dirPath, options_.sniffContent)) {
+                    (entry.directory ? subdirs : files).push_back(std::move(entry.path));
+                }
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            lock.lock();
+            if (error && !error_) {
+                error_ = error;
+            }
+            pendingDirs_.insert(pendingDirs_.end(), std::make_move_iterator(subdirs.begin()), std::make_move_iterator(subdirs.end()));
+            if (!subdirs.empty()) {
+                workAvailable_.notify_all();
+            }
+
+            // Hand over files, pausing while the consumer is behind
+            for (auto& file : files) {
+                resultsChanged_.wait(lock, [this] { return stopping_ || results_.size() < options_.bufferSize; });
+                if (stopping_) {
+                    break;
+                }
+                results_.push_back(std::move(file));
+                resultsChanged_.notify_all();
+            }
+
+            --busyWorkers_;
+            if (busyWorkers_ == 0) {
+                workAvailable_.notify_all();
+                resultsChanged_.notify_all();
+            }
+        }
+    }
+
+    void DirectoryWalker::stop() {
+        stack_.clear();
+        if (workers_.empty()) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        workAvailable_.notify_all();
+        resultsChanged_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+        workers_.clear();
+    }
+
+} // namespace utils
@@ -0,0 +1,188 @@
+#include "../include/store/EmbeddingCache.h"
+#include "../include/utils/Hash.h"
+#include "../include/utils/MappedFile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+namespace store {
+
+    namespace {
+
+        constexpr char FILE_MAGIC[8] = { 'C', 'L', 'I', 'P', 'K', 'V', 'C', '\0' };
+
+        struct FileHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t dim;
+            uint64_t modelKey;
+            uint64_t reserved;
+        };
+        static_assert(sizeof(FileHeader) == 32, "Header must stay 32 bytes");
+
+        // Serialize one record into buffer, trailing hash included
+        void appendRecord(std::string& buffer, std::string_view key, const float* embedding, size_t dim) {
+            const size_t start = buffer.size();
+            const uint32_t keyLength = static_cast<uint32_t>(key.size());
+            buffer.append(reinterpret_cast<const char*>(&keyLength), sizeof(keyLength));
+            buffer.append(key);
+            buffer.append(reinterpret_cast<const char*>(embedding), dim * sizeof(float));
+            const uint64_t hash = utils::hash64(buffer.data() + start, buffer.size() - start);
+            buffer.append(reinterpret_cast<const char*>(&hash), sizeof(hash));
+        }
+
+    } // namespace
+
+    EmbeddingCache::EmbeddingCache(const std::filesystem::path& filePath, size_t dim, uint64_t modelKey)
+        : filePath_(filePath), dim_(dim), modelKey_(modelKey), rewrite_(true) {
+        if (dim_ == 0) {
+            throw std::runtime_error("Embedding cache dimension must be positive");
+        }
+        readFile();
+    }
+
+    EmbeddingCache::~EmbeddingCache() {
+        try {
+            flush();
+        } catch (...) {
+        }
+    }
+
+    bool EmbeddingCache::get(std::string_view key, float* out) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = rows_.find(std::string(key));
+        if (it == rows_.end()) {
+            return false;
+        }
+        std::copy_n(vectors_.data() + it->second * dim_, dim_, out);
+        return true;
+    }
+
+    void EmbeddingCache::put(std::string_view key, const float* embedding, size_t dim) {
+        if (dim != dim_) {
+            throw std::runtime_error("Embedding size does not match cache dimension");
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto [it, inserted] = rows_.try_emplace(std::string(key), rows_.size());
+        if (inserted) {
+            vectors_.insert(vectors_.end(), embedding, embedding + dim);
+        } else {
+            std::copy_n(embedding, dim, vectors_.data() + it->second * dim_);
+        }
+        pending_.push_back(it->first);
+    }
+
+    size_t EmbeddingCache::size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return rows_.size();
+    }
+
+    void EmbeddingCache::flush() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!rewrite_ && pending_.empty()) {
+            return;
+        }
+
+        std::string buffer;
+        if (rewrite_) {
+            // Whole cache through a temporary file, readers never see a half-written header
+            FileHeader header{};
+            std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+            header.version = FORMAT_VERSION;
+            header.dim = static_cast<uint32_t>(dim_);
+            header.modelKey = modelKey_;
+            buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+            for (const auto& [key, row] : rows_) {
+                appendRecord(buffer, key, vectors_.data() + row * dim_, dim_);
+            }
+
+            std::filesystem::path tempPath = filePath_;
+            tempPath += ".tmp";
+            {
+                std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+                if (!file.is_open()) {
+                    throw std::runtime_error("Failed to create file: " + tempPath.string());
+                }
+                file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                if (!file) {
+                    throw std::runtime_error("Failed to write file: " + tempPath.string());
+                }
+            }
+            std::filesystem::rename(tempPath, filePath_);
+        } else {
+            // New records only; a crash mid-write leaves a torn record that the next load drops
+            for (const std::string& key : pending_) {
+                appendRecord(buffer, key, vectors_.data() + rows_.at(key) * dim_, dim_);
+            }
+
+            std::ofstream file(filePath_, std::ios::binary | std::ios::app);
+            if (!file.is_open()) {
+                throw std::runtime_error("Failed to open file: " + filePath_.string());
+            }
+            file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            if (!file) {
+                throw std::runtime_error("Failed to write file: " + filePath_.string());
+            }
+        }
+
+        pending_.clear();
+        rewrite_ = false;
+    }
+
+    void EmbeddingCache::readFile() {
+        std::error_code error;
+        if (!std::filesystem::is_regular_file(filePath_, error)) {
+            return;
+        }
+        // Records are parsed straight from the mapping, so only vectors_ and the keys take heap memory
+        utils::MappedFile file(filePath_);
+        const std::string_view data(reinterpret_cast<const char*>(file.data()), file.size());
+
+        FileHeader header;
+        if (data.size() < sizeof(header)) {
+            return;
+        }
+        std::memcpy(&header, data.data(), sizeof(header));
+        if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.version != FORMAT_VERSION ||
+            header.dim != dim_ || header.modelKey != modelKey_) {
+            return;
+        }
+
+        const size_t vectorBytes = dim_ * sizeof(float);
+        size_t offset = sizeof(header);
+        while (offset < data.size()) {
+            uint32_t keyLength;
+            if (data.size() - offset < sizeof(keyLength)) {
+                break;
+            }
+            std::memcpy(&keyLength, data.data() + offset, sizeof(keyLength));
+
+            const size_t bodySize = sizeof(keyLength) + keyLength + vectorBytes;
+            uint64_t hash;
+            if (data.size() - offset < bodySize + sizeof(hash)) {
+                break;
+            }
+            std::memcpy(&hash, data.data() + offset + bodySize, sizeof(hash));
+            if (hash != utils::hash64(data.data() + offset, bodySize)) {
+                break;
+            }
+
+            std::string key(data.data() + offset + sizeof(keyLength), keyLength);
+            const char* embedding = data.data() + offset + sizeof(keyLength) + keyLength;
+            auto [it, inserted] = rows_.try_emplace(std::move(key), rows_.size());
+            if (inserted) {
+                vectors_.resize(vectors_.size() + dim_);
+            }
+            std::memcpy(vectors_.data() + it->second * dim_, embedding, vectorBytes);
+
+            offset += bodySize + sizeof(hash);
+        }
+
+        // Appending after a damaged tail would hide every later record, so rewrite instead
+        rewrite_ = offset != data.size();
+    }
+
+} // namespace store
@@ -0,0 +1,246 @@
+#include "../include/store/EmbeddingStore.h"
+#include "../include/utils/MappedFile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace store {
+
+    namespace {
+
+        constexpr char FILE_MAGIC[8] = { 'C', 'L', 'I', 'P', 'E', 'M', 'B', '\0' };
+
+        struct FileHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t dim;
+            uint64_t count;
+            uint64_t vectorsOffset;
+            uint64_t entriesOffset;
+            uint64_t stringsOffset;
+            uint64_t stringsSize;
+            uint64_t reserved;
+        };
+        static_assert(sizeof(FileHeader) == 64, "Header must stay 64 bytes");
+
+        uint64_t alignUp(uint64_t value, uint64_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+    } // namespace
+
+    struct EmbeddingStore::IdIndex {
+        std::mutex mutex;
+        bool built = false;
+        std::unordered_map<std::string, size_t> rows;
+    };
+
+    EmbeddingStore::EmbeddingStore(size_t dim)
+        : dim_(dim),
+          count_(0),
+          mappedVectors_(nullptr),
+          mappedEntries_(nullptr),
+          mappedStrings_(nullptr),
+          idIndex_(std::make_unique<IdIndex>()) {
+    }
+
+    EmbeddingStore::~EmbeddingStore() = default;
+    EmbeddingStore::EmbeddingStore(EmbeddingStore&&) noexcept = default;
+    EmbeddingStore& EmbeddingStore::operator=(EmbeddingStore&&) noexcept = default;
+
+    size_t EmbeddingStore::add(std::string_view id, const float* embedding, size_t dim, std::string_view metadata) {
+        if (isMapped()) {
+            throw std::runtime_error("Cannot add rows to a memory-mapped embedding store");
+        }
+        if (count_ == 0 && dim_ == 0) {
+            dim_ = dim;
+        }
+        if (dim != dim_) {
+            throw std::runtime_error("Embedding size does not match store dimension");
+        }
+
+        vectors_.insert(vectors_.end(), embedding, embedding + dim);
+        entries_.push_back({ strings_.size(), static_cast<uint32_t>(id.size()), static_cast<uint32_t>(metadata.size()) });
+        strings_.append(id);
+        strings_.append(metadata);
+
+        size_t index = count_++;
+        std::lock_guard<std::mutex> lock(idIndex_->mutex);
+        if (idIndex_->built) {
+            idIndex_->rows[std::string(id)] = index;
+        }
+        return index;
+    }
+
+    size_t EmbeddingStore::add(std::string_view id, const std::vector<float>& embedding, std::string_view metadata) {
+        return add(id, embedding.data(), embedding.size(), metadata);
+    }
+
+    std::string_view EmbeddingStore::id(size_t i) const {
+        const Entry& entry = entriesData()[i];
+        return std::string_view(stringsData() + entry.offset, entry.idLength);
+    }
+
+    std::string_view EmbeddingStore::metadata(size_t i) const {
+        const Entry& entry = entriesData()[i];
+        return std::string_view(stringsData() + entry.offset + entry.idLength, entry.metadataLength);
+    }
+
+    std::optional<size_t> EmbeddingStore::find(std::string_view id) const {
+        std::lock_guard<std::mutex> lock(idIndex_->mutex);
+        if (!idIndex_->built) {
+            idIndex_->rows.reserve(count_);
+            for (size_t i = 0; i < count_; ++i) {
+                idIndex_->rows[std::string(this->id(i))] = i;
+            }
+            idIndex_->built = true;
+        }
+
+        auto it = idIndex_->rows.find(std::string(id));
+        if (it == idIndex_->rows.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    void EmbeddingStore::save(const std::filesystem::path& filePath) const {
+        FileHeader header{};
+        std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.version = FORMAT_VERSION;
+        header.dim = static_cast<uint32_t>(dim_);
+        header.count = count_;
+        header.vectorsOffset = alignUp(sizeof(FileHeader), math::MATRIX_ALIGNMENT);
+        header.entriesOffset = alignUp(header.vectorsOffset + count_ * dim_ * sizeof(float), alignof(Entry));
+        header.stringsOffset = header.entriesOffset + count_ * sizeof(Entry);
+
+        // Rebase string offsets so the strings section is dense
+        std::vector<Entry> entries(entriesData(), entriesData() + count_);
+        uint64_t offset = 0;
+        for (auto& entry : entries) {
+            entry.offset = offset;
+            offset += entry.idLength + entry.metadataLength;
+        }
+        header.stringsSize = offset;
+
+        std::filesystem::path tempPath = filePath;
+        tempPath += ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                throw std::runtime_error("Failed to create file: " + tempPath.string());
+            }
+
+            auto writeZeros = [&file](uint64_t count) {
+                static const char zeros[64] = {};
+                while (count > 0) {
+                    uint64_t chunk = std::min<uint64_t>(count, sizeof(zeros));
+                    file.write(zeros, static_cast<std::streamsize>(chunk));
+                    count -= chunk;
+                }
+            };
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            writeZeros(header.vectorsOffset - sizeof(header));
+            file.write(reinterpret_cast<const char*>(vectorsData()), static_cast<std::streamsize>(count_ * dim_ * sizeof(float)));
+            writeZeros(header.entriesOffset - (header.vectorsOffset + count_ * dim_ * sizeof(float)));
+            file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(count_ * sizeof(Entry)));
+            for (size_t i = 0; i < count_; ++i) {
+                std::string_view idView = id(i);
+                std::string_view metadataView = metadata(i);
+                file.write(idView.data(), static_cast<std::streamsize>(idView.size()));
+                file.write(metadataView.data(), static_cast<std::streamsize>(metadataView.size()));
+            }
+
+            if (!file) {
+                throw std::runtime_error("Failed to write file: " + tempPath.string());
+            }
+        }
+
+        std::filesystem::rename(tempPath, filePath);
+    }
+
+    EmbeddingStore EmbeddingStore::load(const std::filesystem::path& filePath) {
+        EmbeddingStore mapped = open(filePath);
+
+        // Copy mapped sections into owned storage
+        EmbeddingStore result(mapped.dim_);
+        result.count_ = mapped.count_;
+        result.vectors_.assign(mapped.vectorsData(), mapped.vectorsData() + mapped.count_ * mapped.dim_);
+        result.entries_.assign(mapped.entriesData(), mapped.entriesData() + mapped.count_);
+        // attach() checked every entry against the string section, but entries need not be in offset order
+        uint64_t stringsEnd = 0;
+        for (const Entry& entry : result.entries_) {
+            stringsEnd = std::max<uint64_t>(stringsEnd, entry.offset + entry.idLength + entry.metadataLength);
+        }
+        result.strings_.assign(mapped.stringsData(), static_cast<size_t>(stringsEnd));
+        return result;
+    }
+
+    EmbeddingStore EmbeddingStore::open(const std::filesystem::path& filePath) {
+        EmbeddingStore result;
+        result.attach(std::make_unique<utils::MappedFile>(filePath), filePath);
+        return result;
+    }
+
+    void EmbeddingStore::attach(std::unique_ptr<utils::MappedFile> mapping, const std::filesystem::path& filePath) {
+        const uint8_t* base = mapping->data();
+        const uint64_t fileSize = mapping->size();
+
+        FileHeader header;
+        if (fileSize < sizeof(header)) {
+            throw std::runtime_error("Embedding store file is truncated: " + filePath.string());
+        }
+        std::memcpy(&header, base, sizeof(header));
+
+        if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+            throw std::runtime_error("Not an embedding store file: " + filePath.string());
+        }
+        if (header.version != FORMAT_VERSION) {
+            throw std::runtime_error("Unsupported embedding store version " + std::to_string(header.version) + ": " + filePath.string());
+        }
+
+        // Every section must lie inside the file and be aligned for direct access
+        // Sizes are compared by division against the room left, so a crafted count cannot wrap the products around
+        const uint64_t rowBytes = static_cast<uint64_t>(header.dim) * sizeof(float);
+        const bool sectionsFit =
+            header.vectorsOffset <= header.entriesOffset && header.entriesOffset <= header.stringsOffset &&
+            header.stringsOffset <= fileSize && header.stringsSize <= fileSize - header.stringsOffset &&
+            (header.count == 0 || (rowBytes > 0 && header.count <= (header.entriesOffset - header.vectorsOffset) / rowBytes)) &&
+            header.count <= (header.stringsOffset - header.entriesOffset) / sizeof(Entry);
+        if (header.vectorsOffset % math::MATRIX_ALIGNMENT != 0 || header.entriesOffset % alignof(Entry) != 0 || !sectionsFit) {
+            throw std::runtime_error("Corrupted embedding store file: " + filePath.string());
+        }
+
+        dim_ = header.dim;
+        count_ = static_cast<size_t>(header.count);
+        mappedVectors_ = reinterpret_cast<const float*>(base + header.vectorsOffset);
+        mappedEntries_ = reinterpret_cast<const Entry*>(base + header.entriesOffset);
+        mappedStrings_ = reinterpret_cast<const char*>(base + header.stringsOffset);
+
+        for (size_t i = 0; i < count_; ++i) {
+            const Entry& entry = mappedEntries_[i];
+            if (entry.offset > header.stringsSize ||
+                static_cast<uint64_t>(entry.idLength) + entry.metadataLength > header.stringsSize - entry.offset) {
+                throw std::runtime_error("Corrupted embedding store file: " + filePath.string());
+            }
+        }
+
+        mapping_ = std::move(mapping);
+    }
+
+    const float* EmbeddingStore::vectorsData() const {
+        return isMapped() ? mappedVectors_ : vectors_.data();
+    }
+
+    const EmbeddingStore::Entry* EmbeddingStore::entriesData() const {
+        return isMapped() ? mappedEntries_ : entries_.data();
+    }
+
+    const char* EmbeddingStore::stringsData() const {
+        return isMapped() ? mappedStrings_ : strings_.data();
+    }
+
+} // namespace store
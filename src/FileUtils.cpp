@@ -1,8 +1,17 @@
 #include "../include/utils/FileUtils.h"
 #include "../include/config/Config.h"
+#include "../include/utils/DirectoryWalker.h"
 #include <fstream>
 #include <algorithm>
-#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace utils {
 
@@ -40,7 +49,9 @@ namespace utils {
 
     std::vector<std::filesystem::path> loadTestImages(
         const std::filesystem::path& dirPath,
-        int maxImages
+        int maxImages,
+        int walkThreads,
+        bool sniffContent
     ) {
         if (!std::filesystem::exists(dirPath)) {
             throw std::runtime_error("Directory not found: " + dirPath.string());
@@ -52,19 +63,19 @@ namespace utils {
 
         std::vector<std::filesystem::path> paths;
 
-        // Recursively search for image files
-        for (const auto& entry : std::filesystem::recursive_directory_iterator(dirPath)) {
-            if (entry.is_regular_file() && isImageFile(entry.path())) {
-                paths.push_back(entry.path());
-            }
+        // Recursively search for image files, stop at the limit
+        WalkOptions options;
+        options.limit = maxImages < 0 ? options.limit : static_cast<size_t>(maxImages);
+        options.threads = static_cast<size_t>(std::max(walkThreads, 1));
+        options.sniffContent = sniffContent;
+        DirectoryWalker walker(dirPath, options);
+        while (auto path = walker.next()) {
+            paths.push_back(std::move(*path));
         }
 
-        // Sort paths
-        std::sort(paths.begin(), paths.end());
-
-        // Limit number of images
-        if (paths.size() > static_cast<size_t>(maxImages)) {
-            paths.resize(maxImages);
+        // Sort paths; a sequential walk already yields them in order
+        if (options.threads > 1) {
+            std::sort(paths.begin(), paths.end());
         }
 
         if (paths.empty()) {
@@ -74,13 +85,208 @@ namespace utils {
         return paths;
     }
 
-    bool isImageFile(const std::filesystem::path& filePath) {
-        std::string ext = filePath.extension().string();
-        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    std::vector<uint8_t> readFileDescriptor(int fd) {
+        if (fd < 0) {
+            throw std::runtime_error("Invalid file descriptor");
+        }
+
+        std::vector<uint8_t> data;
+        const size_t chunkSize = 64 * 1024;
+
+        while (true) {
+            size_t offset = data.size();
+            data.resize(offset + chunkSize);
+#ifdef _WIN32
+            int bytesRead = _read(fd, data.data() + offset, static_cast<unsigned int>(chunkSize));
+#else
+            ssize_t bytesRead = ::read(fd, data.data() + offset, chunkSize);
+#endif
+            if (bytesRead < 0) {
+                if (errno == EINTR) {
+                    data.resize(offset);
+                    continue;
+                }
+                throw std::runtime_error("Failed to read file descriptor (errno " + std::to_string(errno) + ")");
+            }
+            data.resize(offset + static_cast<size_t>(bytesRead));
+            if (bytesRead == 0) {
+                break;
+            }
+        }
+
+        return data;
+    }
+
+    namespace {
+
+        struct ExtensionFormat {
+            const char* extension;
+            ImageFormat format;
+        };
+
+        constexpr ExtensionFormat IMAGE_EXTENSIONS[] = {
+            { config::IMAGE_EXT_JPG, ImageFormat::Jpeg },
+            { config::IMAGE_EXT_JPEG, ImageFormat::Jpeg },
+            { config::IMAGE_EXT_PNG, ImageFormat::Png },
+            { config::IMAGE_EXT_WEBP, ImageFormat::WebP },
+            { config::IMAGE_EXT_TIF, ImageFormat::Tiff },
+            { config::IMAGE_EXT_TIFF, ImageFormat::Tiff },
+            { config::IMAGE_EXT_BMP, ImageFormat::Bmp },
+            { config::IMAGE_EXT_AVIF, ImageFormat::Avif },
+            { config::IMAGE_EXT_JXL, ImageFormat::JpegXl },
+        };
+
+        bool startsWith(const uint8_t* data, size_t size, size_t offset, const char* signature, size_t length) {
+            return size >= offset + length && std::memcmp(data + offset, signature, length) == 0;
+        }
+
+        // ASCII lower case of a narrow or wide character; other characters are left alone
+        template <typename Char>
+        Char asciiLower(Char c) {
+            return c >= Char('A') && c <= Char('Z') ? static_cast<Char>(c - Char('A') + Char('a')) : c;
+        }
+
+        // b is ASCII; a may be a narrow or native wide string
+        template <typename Char>
+        bool asciiEqualsIgnoreCase(std::basic_string_view<Char> a, std::string_view b) {
+            if (a.size() != b.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < a.size(); ++i) {
+                if (asciiLower(a[i]) != static_cast<Char>(asciiLower(b[i]))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template <typename Char>
+        ImageFormat formatFromName(std::basic_string_view<Char> fileName) {
+            // Extension as std::filesystem sees it: from the last dot of the last component, not a leading dot
+            const Char separators[] = { Char('/'), Char('\\'), Char('\0') };
+            size_t dot = fileName.find_last_of(Char('.'));
+            size_t slash = fileName.find_last_of(separators);
+            size_t start = slash == std::basic_string_view<Char>::npos ? 0 : slash + 1;
+            if (dot == std::basic_string_view<Char>::npos || dot <= start) {
+                return ImageFormat::Unknown;
+            }
+
+            std::basic_string_view<Char> extension = fileName.substr(dot);
+            for (const auto& entry : IMAGE_EXTENSIONS) {
+                if (asciiEqualsIgnoreCase(extension, entry.extension)) {
+                    return entry.format;
+                }
+            }
+            return ImageFormat::Unknown;
+        }
+
+    } // namespace
+
+    const char* imageFormatName(ImageFormat format) {
+        switch (format) {
+        case ImageFormat::Jpeg: return "JPEG";
+        case ImageFormat::Png: return "PNG";
+        case ImageFormat::WebP: return "WebP";
+        case ImageFormat::Tiff: return "TIFF";
+        case ImageFormat::Bmp: return "BMP";
+        case ImageFormat::Avif: return "AVIF";
+        case ImageFormat::JpegXl: return "JPEG XL";
+        default: return "unknown";
+        }
+    }
+
+    bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+        return asciiEqualsIgnoreCase(a, b);
+    }
+
+    bool equalsIgnoreCase(std::wstring_view a, std::string_view b) {
+        return asciiEqualsIgnoreCase(a, b);
+    }
+
+    ImageFormat imageFormatFromName(std::string_view fileName) {
+        return formatFromName(fileName);
+    }
 
-        return ext == config::IMAGE_EXT_JPG ||
-               ext == config::IMAGE_EXT_JPEG ||
-               ext == config::IMAGE_EXT_PNG;
+    ImageFormat imageFormatFromName(std::wstring_view fileName) {
+        return formatFromName(fileName);
+    }
+
+    ImageFormat sniffImageFormat(const uint8_t* data, size_t size) {
+        if (data == nullptr) {
+            return ImageFormat::Unknown;
+        }
+        if (startsWith(data, size, 0, "\xFF\xD8\xFF", 3)) {
+            return ImageFormat::Jpeg;
+        }
+        if (startsWith(data, size, 0, "\x89PNG\r\n\x1A\n", 8)) {
+            return ImageFormat::Png;
+        }
+        if (startsWith(data, size, 0, "RIFF", 4) && startsWith(data, size, 8, "WEBP", 4)) {
+            return ImageFormat::WebP;
+        }
+        if (startsWith(data, size, 0, "II*\0", 4) || startsWith(data, size, 0, "MM\0*", 4)) {
+            return ImageFormat::Tiff;
+        }
+        if (startsWith(data, size, 0, "BM", 2)) {
+            return ImageFormat::Bmp;
+        }
+        // ISO base media file: box size, "ftyp", major brand, minor version, then compatible brands
+        // HEIF-style files may carry a generic major brand (e.g. "mif1") and list "avif" among the compatible ones
+        if (startsWith(data, size, 4, "ftyp", 4)) {
+            const size_t boxSize = (size_t(data[0]) << 24) | (size_t(data[1]) << 16) | (size_t(data[2]) << 8) | size_t(data[3]);
+            const size_t end = std::min(boxSize, size);
+            for (size_t offset = 8; offset + 4 <= end; offset += offset == 8 ? 8 : 4) {
+                if (startsWith(data, size, offset, "avif", 4) || startsWith(data, size, offset, "avis", 4)) {
+                    return ImageFormat::Avif;
+                }
+            }
+        }
+        // Bare codestream or the ISO BMFF container
+        if (startsWith(data, size, 0, "\xFF\x0A", 2) || startsWith(data, size, 0, "\0\0\0\x0CJXL \r\n\x87\n", 12)) {
+            return ImageFormat::JpegXl;
+        }
+        return ImageFormat::Unknown;
+    }
+
+    bool isDecodableImageFormat(ImageFormat format) {
+        switch (format) {
+        case ImageFormat::Jpeg:
+        case ImageFormat::Png:
+        case ImageFormat::WebP:
+        case ImageFormat::Tiff:
+        case ImageFormat::Bmp:
+            return true;
+#ifdef CLIP_HAVE_AVIF
+        case ImageFormat::Avif:
+            return true;
+#endif
+#ifdef CLIP_HAVE_JXL
+        case ImageFormat::JpegXl:
+            return true;
+#endif
+        default:
+            return false;
+        }
+    }
+
+    bool isImageFileName(std::string_view fileName) {
+        return isDecodableImageFormat(imageFormatFromName(fileName));
+    }
+
+    ImageFormat sniffImageFile(const std::filesystem::path& filePath) {
+        std::ifstream file(filePath, std::ios::binary);
+        uint8_t head[IMAGE_SNIFF_BYTES];
+        file.read(reinterpret_cast<char*>(head), sizeof(head));
+        return sniffImageFormat(head, static_cast<size_t>(file.gcount()));
+    }
+
+    bool isImageFile(const std::filesystem::path& filePath, bool sniffContent) {
+        // Native string: wide on Windows, so no conversion or allocation either way
+        const ImageFormat byName = imageFormatFromName(filePath.native());
+        if (byName != ImageFormat::Unknown || !sniffContent) {
+            return isDecodableImageFormat(byName);
+        }
+        return isDecodableImageFormat(sniffImageFile(filePath));
     }
 
 } // namespace utils
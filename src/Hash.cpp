@@ -0,0 +1,137 @@
+#include "../include/utils/Hash.h"
+#include "../include/utils/MappedFile.h"
+#include <cstring>
+
+namespace utils {
+
+    namespace {
+
+        constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+        constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+        constexpr uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+        constexpr uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+        constexpr uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+        uint64_t rotl(uint64_t x, int r) {
+            return (x << r) | (x >> (64 - r));
+        }
+
+        // Unaligned little-endian loads; every supported target is little-endian
+        uint64_t read64(const uint8_t* p) {
+            uint64_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        uint32_t read32(const uint8_t* p) {
+            uint32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        uint64_t round(uint64_t acc, uint64_t input) {
+            acc += input * PRIME2;
+            acc = rotl(acc, 31);
+            return acc * PRIME1;
+        }
+
+        uint64_t mergeRound(uint64_t acc, uint64_t value) {
+            acc ^= round(0, value);
+            return acc * PRIME1 + PRIME4;
+        }
+
+        // Four independent lanes over 32-byte stripes; returns the first byte not consumed
+        const uint8_t* consumeStripes(const uint8_t* p, const uint8_t* end, uint64_t seed, uint64_t v[4]) {
+            v[0] = seed + PRIME1 + PRIME2;
+            v[1] = seed + PRIME2;
+            v[2] = seed;
+            v[3] = seed - PRIME1;
+            const uint8_t* limit = end - 32;
+            do {
+                v[0] = round(v[0], read64(p));
+                v[1] = round(v[1], read64(p + 8));
+                v[2] = round(v[2], read64(p + 16));
+                v[3] = round(v[3], read64(p + 24));
+                p += 32;
+            } while (p <= limit);
+            return p;
+        }
+
+        uint64_t mergeLanes(uint64_t v1, uint64_t v2, uint64_t v3, uint64_t v4) {
+            uint64_t h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+            h = mergeRound(h, v1);
+            h = mergeRound(h, v2);
+            h = mergeRound(h, v3);
+            return mergeRound(h, v4);
+        }
+
+        // Length, the bytes after the last stripe and the final avalanche
+        uint64_t finish(uint64_t h, const uint8_t* p, const uint8_t* end, size_t size) {
+            h += static_cast<uint64_t>(size);
+
+            // Tail: 8, 4, then 1 byte at a time
+            for (; p + 8 <= end; p += 8) {
+                h ^= round(0, read64(p));
+                h = rotl(h, 27) * PRIME1 + PRIME4;
+            }
+            if (p + 4 <= end) {
+                h ^= static_cast<uint64_t>(read32(p)) * PRIME1;
+                h = rotl(h, 23) * PRIME2 + PRIME3;
+                p += 4;
+            }
+            for (; p < end; ++p) {
+                h ^= (*p) * PRIME5;
+                h = rotl(h, 11) * PRIME1;
+            }
+
+            h ^= h >> 33;
+            h *= PRIME2;
+            h ^= h >> 29;
+            h *= PRIME3;
+            h ^= h >> 32;
+            return h;
+        }
+
+    } // namespace
+
+    uint64_t hash64(const void* data, size_t size, uint64_t seed) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        const uint8_t* end = p + size;
+        uint64_t h;
+
+        if (size >= 32) {
+            uint64_t v[4];
+            p = consumeStripes(p, end, seed, v);
+            h = mergeLanes(v[0], v[1], v[2], v[3]);
+        } else {
+            h = seed + PRIME5;
+        }
+        return finish(h, p, end, size);
+    }
+
+    Hash128 hash128(const void* data, size_t size, uint64_t seed) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        const uint8_t* end = p + size;
+        Hash128 result;
+
+        if (size >= 32) {
+            // One pass over the stripes; the lanes are merged twice, in opposite orders
+            uint64_t v[4];
+            p = consumeStripes(p, end, seed, v);
+            result.low = mergeLanes(v[0], v[1], v[2], v[3]);
+            result.high = mergeLanes(v[3], v[2], v[1], v[0]);
+        } else {
+            result.low = seed + PRIME5;
+            result.high = seed + PRIME5 + PRIME1;
+        }
+        result.low = finish(result.low, p, end, size);
+        result.high = finish(result.high ^ PRIME3, p, end, size);
+        return result;
+    }
+
+    uint64_t hashFile(const std::filesystem::path& filePath, uint64_t seed) {
+        MappedFile file(filePath);
+        return hash64(file.data(), file.size(), seed);
+    }
+
+} // namespace utils
@@ -0,0 +1,432 @@
+#include "../include/ann/HnswIndex.h"
+#include "../include/math/SimdKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+
+namespace ann {
+
+    namespace {
+
+        constexpr char FILE_MAGIC[8] = { 'C', 'L', 'I', 'P', 'H', 'N', 'S', 'W' };
+
+        struct FileHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t dim;
+            uint64_t count;
+            uint32_t m;
+            uint32_t efConstruction;
+            int32_t maxLevel;
+            uint32_t entryPoint;
+            uint32_t seed;
+            uint8_t reserved[20];
+        };
+        static_assert(sizeof(FileHeader) == 64, "Header must stay 64 bytes");
+
+        // Visit marks reused across searches on the same thread; bumping the epoch clears them in O(1)
+        struct VisitedSet {
+            std::vector<uint32_t> marks;
+            uint32_t epoch = 0;
+
+            void reset(size_t size) {
+                if (marks.size() < size) {
+                    marks.resize(size, 0);
+                }
+                if (++epoch == 0) {
+                    std::fill(marks.begin(), marks.end(), 0);
+                    epoch = 1;
+                }
+            }
+
+            // Returns false if node was already visited
+            bool visit(uint32_t node) {
+                if (marks[node] == epoch) {
+                    return false;
+                }
+                marks[node] = epoch;
+                return true;
+            }
+        };
+
+        VisitedSet& visitedSet() {
+            thread_local VisitedSet visited;
+            return visited;
+        }
+
+        template <typename T>
+        void readExact(std::ifstream& file, T* data, size_t count, const std::filesystem::path& filePath) {
+            file.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+            if (!file) {
+                throw std::runtime_error("HNSW index file is truncated: " + filePath.string());
+            }
+        }
+
+    } // namespace
+
+    HnswIndex::HnswIndex(size_t dim, HnswOptions options)
+        : dim_(dim),
+          options_(options),
+          vectors_(0, dim),
+          maxLevel_(-1),
+          entryPoint_(0),
+          rng_(options.seed) {
+        if (options_.m < 2) {
+            throw std::runtime_error("HNSW M must be at least 2");
+        }
+        options_.efConstruction = std::max(options_.efConstruction, options_.m);
+        levelMultiplier_ = 1.0 / std::log(static_cast<double>(options_.m));
+    }
+
+    uint32_t* HnswIndex::linkBlock(uint32_t node, int level) {
+        if (level == 0) {
+            return baseLinks_.data() + node * (maxLinks(0) + 1);
+        }
+        return upperLinks_[node].data() + (level - 1) * (maxLinks(level) + 1);
+    }
+
+    const uint32_t* HnswIndex::linkBlock(uint32_t node, int level) const {
+        return const_cast<HnswIndex*>(this)->linkBlock(node, level);
+    }
+
+    int HnswIndex::randomLevel() {
+        std::uniform_real_distribution<double> distribution(0.0, 1.0);
+        double u = 1.0 - distribution(rng_);  // (0, 1]
+        return static_cast<int>(-std::log(u) * levelMultiplier_);
+    }
+
+    float HnswIndex::similarity(const float* query, uint32_t node) const {
+        return math::dotProduct(query, vectors_.row(node), dim_);
+    }
+
+    uint32_t HnswIndex::descend(const float* query, uint32_t entry, int fromLevel, int toLevel) const {
+        uint32_t current = entry;
+        float best = similarity(query, current);
+
+        for (int level = fromLevel; level > toLevel; --level) {
+            bool changed = true;
+            while (changed) {
+                changed = false;
+                const uint32_t* block = linkBlock(current, level);
+                for (uint32_t i = 1; i <= block[0]; ++i) {
+                    float score = similarity(query, block[i]);
+                    if (score > best) {
+                        best = score;
+                        current = block[i];
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        return current;
+    }
+
+    std::vector<HnswIndex::Candidate> HnswIndex::searchLayer(const float* query, uint32_t entry, size_t ef, int level) const {
+        VisitedSet& visited = visitedSet();
+        visited.reset(size());
+
+        // candidates: closest first; results: worst of the current best ef on top
+        std::priority_queue<Candidate> candidates;
+        std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> results;
+
+        visited.visit(entry);
+        Candidate start(similarity(query, entry), entry);
+        candidates.push(start);
+        results.push(start);
+
+        while (!candidates.empty()) {
+            Candidate current = candidates.top();
+            if (results.size() >= ef && current.first < results.top().first) {
+                break;
+            }
+            candidates.pop();
+
+            const uint32_t* block = linkBlock(current.second, level);
+            for (uint32_t i = 1; i <= block[0]; ++i) {
+                uint32_t neighbor = block[i];
+                if (!visited.visit(neighbor)) {
+                    continue;
+                }
+
+                float score = similarity(query, neighbor);
+                if (results.size() < ef || score > results.top().first) {
+                    candidates.emplace(score, neighbor);
+                    results.emplace(score, neighbor);
+                    if (results.size() > ef) {
+                        results.pop();
+                    }
+                }
+            }
+        }
+
+        std::vector<Candidate> sorted(results.size());
+        for (size_t i = sorted.size(); i-- > 0;) {
+            sorted[i] = results.top();
+            results.pop();
+        }
+        return sorted;
+    }
+
+    std::vector<uint32_t> HnswIndex::selectNeighbors(const std::vector<Candidate>& candidates, size_t maxCount) const {
+        std::vector<uint32_t> selected;
+        selected.reserve(maxCount);
+
+        for (const auto& candidate : candidates) {
+            if (selected.size() >= maxCount) {
+                break;
+            }
+
+            // Skip candidates reachable through a closer selected neighbour; keeps links spread in all directions
+            const float* candidateVector = vectors_.row(candidate.second);
+            bool keep = true;
+            for (uint32_t other : selected) {
+                if (similarity(candidateVector, other) > candidate.first) {
+                    keep = false;
+                    break;
+                }
+            }
+            if (keep) {
+                selected.push_back(candidate.second);
+            }
+        }
+
+        return selected;
+    }
+
+    void HnswIndex::connect(uint32_t node, uint32_t neighbor, int level) {
+        uint32_t* block = linkBlock(node, level);
+        const size_t capacity = maxLinks(level);
+
+        if (block[0] < capacity) {
+            block[++block[0]] = neighbor;
+            return;
+        }
+
+        // Full: re-select among existing links plus the new one
+        const float* nodeVector = vectors_.row(node);
+        std::vector<Candidate> candidates;
+        candidates.reserve(capacity + 1);
+        for (uint32_t i = 1; i <= block[0]; ++i) {
+            candidates.emplace_back(similarity(nodeVector, block[i]), block[i]);
+        }
+        candidates.emplace_back(similarity(nodeVector, neighbor), neighbor);
+        std::sort(candidates.begin(), candidates.end(), std::greater<Candidate>());
+
+        std::vector<uint32_t> selected = selectNeighbors(candidates, capacity);
+        block[0] = static_cast<uint32_t>(selected.size());
+        std::copy(selected.begin(), selected.end(), block + 1);
+    }
+
+    uint32_t HnswIndex::insert(const float* vector) {
+        const uint32_t node = static_cast<uint32_t>(size());
+        const int level = randomLevel();
+
+        vectors_.appendRow(vector, dim_);
+        math::normalize(vectors_.row(node), dim_);
+        levels_.push_back(level);
+        baseLinks_.resize(baseLinks_.size() + maxLinks(0) + 1, 0);
+        upperLinks_.emplace_back(static_cast<size_t>(level) * (maxLinks(1) + 1), 0);
+
+        if (maxLevel_ < 0) {
+            maxLevel_ = level;
+            entryPoint_ = node;
+            return node;
+        }
+
+        const float* query = vectors_.row(node);
+        uint32_t entry = descend(query, entryPoint_, maxLevel_, level);
+
+        for (int l = std::min(level, maxLevel_); l >= 0; --l) {
+            std::vector<Candidate> candidates = searchLayer(query, entry, options_.efConstruction, l);
+            std::vector<uint32_t> neighbors = selectNeighbors(candidates, options_.m);
+
+            uint32_t* block = linkBlock(node, l);
+            block[0] = static_cast<uint32_t>(neighbors.size());
+            std::copy(neighbors.begin(), neighbors.end(), block + 1);
+            for (uint32_t neighbor : neighbors) {
+                connect(neighbor, node, l);
+            }
+
+            entry = candidates.front().second;
+        }
+
+        if (level > maxLevel_) {
+            maxLevel_ = level;
+            entryPoint_ = node;
+        }
+
+        return node;
+    }
+
+    void HnswIndex::build(const math::MatrixView& vectors) {
+        if (vectors.cols != dim_ && !vectors.empty()) {
+            throw std::runtime_error("Vector dimension does not match HNSW index");
+        }
+
+        vectors_.reserveRows(size() + vectors.rows);
+        levels_.reserve(size() + vectors.rows);
+        baseLinks_.reserve((size() + vectors.rows) * (maxLinks(0) + 1));
+        upperLinks_.reserve(size() + vectors.rows);
+
+        for (size_t i = 0; i < vectors.rows; ++i) {
+            insert(vectors.row(i));
+        }
+    }
+
+    std::vector<math::ScoredIndex> HnswIndex::search(const float* query, size_t k, size_t ef) const {
+        std::vector<math::ScoredIndex> matches;
+        if (empty() || k == 0) {
+            return matches;
+        }
+
+        thread_local std::vector<float> normalized;
+        normalized.assign(query, query + dim_);
+        math::normalize(normalized.data(), dim_);
+
+        uint32_t entry = descend(normalized.data(), entryPoint_, maxLevel_, 0);
+        std::vector<Candidate> candidates = searchLayer(normalized.data(), entry, std::max(ef, k), 0);
+
+        size_t count = std::min(k, candidates.size());
+        matches.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            matches.push_back({ candidates[i].second, candidates[i].first });
+        }
+
+        // Same order as math::topKSimilarity: ties go to the lower index
+        std::sort(matches.begin(), matches.end(), [](const math::ScoredIndex& a, const math::ScoredIndex& b) {
+            return a.score != b.score ? a.score > b.score : a.index < b.index;
+        });
+        return matches;
+    }
+
+    math::TopK HnswIndex::search(const math::MatrixView& queries, size_t k, size_t ef) const {
+        if (queries.cols != dim_ && !queries.empty()) {
+            throw std::runtime_error("Query dimension does not match HNSW index");
+        }
+
+        math::TopK result;
+        result.rows = queries.rows;
+        result.k = std::min(k, size());
+        result.entries.resize(result.rows * result.k, { 0, 0.0f });
+
+        for (size_t i = 0; i < queries.rows; ++i) {
+            std::vector<math::ScoredIndex> matches = search(queries.row(i), result.k, ef);
+            std::copy(matches.begin(), matches.end(), result.entries.begin() + i * result.k);
+        }
+
+        return result;
+    }
+
+    void HnswIndex::save(const std::filesystem::path& filePath) const {
+        FileHeader header{};
+        std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.version = FORMAT_VERSION;
+        header.dim = static_cast<uint32_t>(dim_);
+        header.count = size();
+        header.m = static_cast<uint32_t>(options_.m);
+        header.efConstruction = static_cast<uint32_t>(options_.efConstruction);
+        header.maxLevel = maxLevel_;
+        header.entryPoint = entryPoint_;
+        header.seed = options_.seed;
+
+        std::filesystem::path tempPath = filePath;
+        tempPath += ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                throw std::runtime_error("Failed to create file: " + tempPath.string());
+            }
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(vectors_.data()), static_cast<std::streamsize>(size() * dim_ * sizeof(float)));
+            std::vector<int32_t> levels(levels_.begin(), levels_.end());
+            file.write(reinterpret_cast<const char*>(levels.data()), static_cast<std::streamsize>(levels.size() * sizeof(int32_t)));
+            file.write(reinterpret_cast<const char*>(baseLinks_.data()), static_cast<std::streamsize>(baseLinks_.size() * sizeof(uint32_t)));
+            for (const auto& links : upperLinks_) {
+                file.write(reinterpret_cast<const char*>(links.data()), static_cast<std::streamsize>(links.size() * sizeof(uint32_t)));
+            }
+
+            if (!file) {
+                throw std::runtime_error("Failed to write file: " + tempPath.string());
+            }
+        }
+
+        std::filesystem::rename(tempPath, filePath);
+    }
+
+    HnswIndex HnswIndex::load(const std::filesystem::path& filePath) {
+        std::ifstream file(filePath, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file: " + filePath.string());
+        }
+
+        FileHeader header;
+        readExact(file, &header, 1, filePath);
+        if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+            throw std::runtime_error("Not an HNSW index file: " + filePath.string());
+        }
+        if (header.version != FORMAT_VERSION) {
+            throw std::runtime_error("Unsupported HNSW index version " + std::to_string(header.version) + ": " + filePath.string());
+        }
+
+        HnswOptions options;
+        options.m = header.m;
+        options.efConstruction = header.efConstruction;
+        // Fresh random stream for levels of rows inserted after loading
+        options.seed = header.seed + static_cast<uint32_t>(header.count);
+
+        HnswIndex index(header.dim, options);
+        const size_t count = static_cast<size_t>(header.count);
+
+        index.vectors_ = math::Matrix(count, header.dim);
+        readExact(file, index.vectors_.data(), count * header.dim, filePath);
+
+        std::vector<int32_t> levels(count);
+        readExact(file, levels.data(), count, filePath);
+        index.levels_.assign(levels.begin(), levels.end());
+
+        index.baseLinks_.resize(count * (index.maxLinks(0) + 1));
+        readExact(file, index.baseLinks_.data(), index.baseLinks_.size(), filePath);
+
+        index.upperLinks_.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            if (levels[i] < 0 || levels[i] > header.maxLevel) {
+                throw std::runtime_error("Corrupted HNSW index file: " + filePath.string());
+            }
+            index.upperLinks_[i].resize(static_cast<size_t>(levels[i]) * (index.maxLinks(1) + 1));
+            readExact(file, index.upperLinks_[i].data(), index.upperLinks_[i].size(), filePath);
+        }
+
+        // Every link must point at an existing row
+        auto validLinks = [&](const uint32_t* block, size_t capacity) {
+            if (block[0] > capacity) {
+                return false;
+            }
+            return std::all_of(block + 1, block + 1 + block[0], [count](uint32_t node) { return node < count; });
+        };
+        for (size_t i = 0; i < count; ++i) {
+            bool valid = validLinks(index.linkBlock(static_cast<uint32_t>(i), 0), index.maxLinks(0));
+            for (int level = 1; valid && level <= index.levels_[i]; ++level) {
+                valid = validLinks(index.linkBlock(static_cast<uint32_t>(i), level), index.maxLinks(level));
+            }
+            if (!valid) {
+                throw std::runtime_error("Corrupted HNSW index file: " + filePath.string());
+            }
+        }
+
+        if (count > 0 && (header.entryPoint >= count || levels[header.entryPoint] != header.maxLevel)) {
+            throw std::runtime_error("Corrupted HNSW index file: " + filePath.string());
+        }
+        index.maxLevel_ = count > 0 ? header.maxLevel : -1;
+        index.entryPoint_ = header.entryPoint;
+        index.options_.seed = header.seed;
+
+        return index;
+    }
+
+} // namespace ann
@@ -0,0 +1,64 @@
+#include "../include/pipeline/ImageListReader.h"
+#include "../include/utils/BufferPool.h"
+#include "../include/utils/InputFile.h"
+#include <filesystem>
+#include <stdexcept>
+
+namespace pipeline {
+
+    ImageListReader::ImageListReader(std::istream& input, size_t limit)
+        : input_(input),
+          limit_(limit),
+          exhausted_(limit == 0) {
+    }
+
+    std::optional<EncodedImage> ImageListReader::next() {
+        EncodedImage image{ 0, {}, {} };
+        std::string filePath;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::string line;
+            while (!exhausted_ && filePath.empty()) {
+                if (!std::getline(input_, line)) {
+                    exhausted_ = true;
+                    break;
+                }
+                // Lists written on Windows keep the '\r' of CRLF line ends
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                if (!line.empty() && line[0] != '#') {
+                    filePath = std::move(line);
+                }
+            }
+            if (filePath.empty()) {
+                return std::nullopt;
+            }
+
+            image.index = paths_.size();
+            paths_.push_back(filePath);
+            if (paths_.size() >= limit_) {
+                exhausted_ = true;
+            }
+        }
+
+        // Outside the lock, so decode threads read their files in parallel. List lines are UTF-8;
+        // u8path keeps non-ASCII names intact where the narrow path API uses the ANSI code page
+        try {
+            utils::InputFile file(std::filesystem::u8path(filePath));
+            image.data = utils::byteBufferPool().acquire(file.size());
+            file.readAll(image.data.data());
+        } catch (const std::exception& e) {
+            utils::byteBufferPool().release(std::move(image.data));
+            image.data.clear();
+            image.error = e.what();
+        }
+        return image;
+    }
+
+    std::string ImageListReader::path(size_t index) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return paths_.at(index);
+    }
+
+} // namespace pipeline
@@ -0,0 +1,256 @@
+#include "../include/pipeline/ImagePipeline.h"
+#include "../include/pipeline/BoundedQueue.h"
+#include "../include/pipeline/PrefetchReader.h"
+#include "../include/config/Config.h"
+#include "../include/utils/BufferPool.h"
+#include "../include/utils/MappedFile.h"
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <stdexcept>
+#include <mutex>
+#include <thread>
+#include <exception>
+
+namespace pipeline {
+
+    namespace {
+
+        // Files past the one being read that are announced to the OS for readahead
+        constexpr size_t PREFETCH_ADVISE_AHEAD = 32;
+
+        // Preprocessed images ready for one encoder call
+        struct Batch {
+            std::vector<size_t> indices;
+            std::vector<std::string> cacheKeys;     // image cache key per index, empty without a cache
+            std::vector<float> tensor;          // [indices.size(), 3, 224, 224]
+            std::vector<uint8_t> tensorUint8;   // same, for encoders with folded normalization
+        };
+
+        int resolveThreadCount(int requested) {
+            if (requested > 0) {
+                return requested;
+            }
+            unsigned int hw = std::thread::hardware_concurrency();
+            return hw > 0 ? static_cast<int>(hw) : 1;
+        }
+
+    } // namespace
+
+    ImagePipeline::ImagePipeline(clip::CLIPInference& clip, const PipelineOptions& options)
+        : clip_(clip), options_(options) {
+        options_.decodeThreads = resolveThreadCount(options_.decodeThreads);
+        options_.inferenceThreads = std::max(1, options_.inferenceThreads);
+        options_.batchSize = clip_.supportsImageBatch() ? std::max(1, options_.batchSize) : 1;
+        options_.queueDepth = std::max(1, options_.queueDepth);
+        options_.prefetchThreads = std::max(0, options_.prefetchThreads);
+    }
+
+    ImagePipeline::~ImagePipeline() = default;
+
+    void ImagePipeline::run(
+        const std::vector<std::filesystem::path>& imagePaths,
+        const ResultCallback& onResult,
+        const ErrorCallback& onError
+    ) {
+        if (imagePaths.empty()) {
+            return;
+        }
+
+        // Optional reader stage: file bytes arrive ahead of the decoders, which then decode from memory
+        if (options_.prefetchThreads > 0) {
+            PrefetchOptions prefetchOptions{ options_.prefetchThreads, options_.prefetchBytes, PREFETCH_ADVISE_AHEAD };
+            PrefetchReader reader(imagePaths, prefetchOptions);
+            runStages(imagePaths, &reader, onResult, onError);
+        } else {
+            runStages(imagePaths, nullptr, onResult, onError);
+        }
+    }
+
+    void ImagePipeline::run(ImageSource& source, const ResultCallback& onResult, const ErrorCallback& onError) {
+        runStages({}, &source, onResult, onError);
+    }
+
+    void ImagePipeline::runStages(
+        const std::vector<std::filesystem::path>& imagePaths,
+        ImageSource* reader,
+        const ResultCallback& onResult,
+        const ErrorCallback& onError
+    ) {
+        const size_t tensorSize = static_cast<size_t>(config::IMAGE_CHANNELS) * config::IMAGE_SIZE * config::IMAGE_SIZE;
+        const size_t batchSize = static_cast<size_t>(options_.batchSize);
+        const bool uint8Input = clip_.hasUint8ImageInput();
+        const bool cached = clip_.hasImageCache();
+
+        BoundedQueue<Batch> queue(static_cast<size_t>(options_.queueDepth));
+        std::atomic<size_t> nextIndex{0};
+        std::atomic<int> activeDecoders{options_.decodeThreads};
+        std::mutex callbackMutex;
+
+        auto reportError = [&](size_t index, const std::string& message) {
+            std::lock_guard<std::mutex> lock(callbackMutex);
+            onError(index, message);
+        };
+
+        // Preprocess encoded image bytes into the next slot of batch
+        // With an image cache, images seen before are reported right away and take no slot
+        auto addEncodedImage = [&](size_t index, const uint8_t* data, size_t size, Batch& batch) {
+            std::string key;
+            if (cached) {
+                key = clip::CLIPInference::imageContentKey(data, size);
+                std::vector<float> embedding;
+                if (clip_.findCachedImage(key, embedding)) {
+                    std::lock_guard<std::mutex> lock(callbackMutex);
+                    onResult(index, std::move(embedding));
+                    return;
+                }
+            }
+
+            size_t offset = batch.indices.size() * tensorSize;
+            if (uint8Input) {
+                std::vector<uint8_t> tensor = clip_.preprocessImageUint8(data, size);
+                std::copy(tensor.begin(), tensor.end(), batch.tensorUint8.begin() + offset);
+                utils::byteBufferPool().release(std::move(tensor));
+            } else {
+                std::vector<float> tensor = clip_.preprocessImage(data, size);
+                std::copy(tensor.begin(), tensor.end(), batch.tensor.begin() + offset);
+                utils::floatBufferPool().release(std::move(tensor));
+            }
+            if (cached) {
+                batch.cacheKeys.push_back(std::move(key));
+            }
+            batch.indices.push_back(index);
+        };
+
+        // Decode stage: each worker claims up to batchSize images and packs them into one batch
+        // Without a source the claim is a contiguous index range, with one it is whatever images are ready
+        auto decodeWorker = [&]() {
+            while (true) {
+                std::vector<EncodedImage> files;
+                size_t begin = 0;
+                size_t count = 0;
+                if (reader) {
+                    while (files.size() < batchSize) {
+                        std::optional<EncodedImage> file = reader->next();
+                        if (!file) {
+                            break;
+                        }
+                        files.push_back(std::move(*file));
+                    }
+                    count = files.size();
+                } else {
+                    begin = nextIndex.fetch_add(batchSize);
+                    count = begin < imagePaths.size() ? std::min(batchSize, imagePaths.size() - begin) : 0;
+                }
+                if (count == 0) {
+                    break;
+                }
+
+                Batch batch;
+                batch.indices.reserve(count);
+                if (uint8Input) {
+                    batch.tensorUint8 = utils::byteBufferPool().acquire(count * tensorSize);
+                } else {
+                    batch.tensor = utils::floatBufferPool().acquire(count * tensorSize);
+                }
+
+                for (size_t n = 0; n < count; ++n) {
+                    const size_t i = reader ? files[n].index : begin + n;
+                    try {
+                        if (reader) {
+                            if (!files[n].error.empty()) {
+                                throw std::runtime_error(files[n].error);
+                            }
+                            addEncodedImage(i, files[n].data.data(), files[n].data.size(), batch);
+                        } else if (cached) {
+                            // Cache keys come from the file bytes, so decode from the mapping
+                            utils::MappedFile file(imagePaths[i]);
+                            addEncodedImage(i, file.data(), file.size(), batch);
+                        } else {
+                            size_t offset = batch.indices.size() * tensorSize;
+                            if (uint8Input) {
+                                std::vector<uint8_t> tensor = clip_.preprocessImageUint8(imagePaths[i]);
+                                std::copy(tensor.begin(), tensor.end(), batch.tensorUint8.begin() + offset);
+                                utils::byteBufferPool().release(std::move(tensor));
+                            } else {
+                                std::vector<float> tensor = clip_.preprocessImage(imagePaths[i]);
+                                std::copy(tensor.begin(), tensor.end(), batch.tensor.begin() + offset);
+                                utils::floatBufferPool().release(std::move(tensor));
+                            }
+                            batch.indices.push_back(i);
+                        }
+                    } catch (const std::exception& e) {
+                        reportError(i, e.what());
+                    }
+                    if (reader) {
+                        utils::byteBufferPool().release(std::move(files[n].data));
+                    }
+                }
+
+                // Drop slots of images that failed to load or came from the cache
+                if (uint8Input) {
+                    batch.tensorUint8.resize(batch.indices.size() * tensorSize);
+                } else {
+                    batch.tensor.resize(batch.indices.size() * tensorSize);
+                }
+
+                if (batch.indices.empty()) {
+                    utils::byteBufferPool().release(std::move(batch.tensorUint8));
+                    utils::floatBufferPool().release(std::move(batch.tensor));
+                    continue;
+                }
+
+                if (!queue.push(std::move(batch))) {
+                    break;
+                }
+            }
+
+            // Last decoder out closes the queue so inference workers can finish
+            if (activeDecoders.fetch_sub(1) == 1) {
+                queue.close();
+            }
+        };
+
+        // Inference stage: encode ready batches
+        auto inferenceWorker = [&]() {
+            while (auto batch = queue.pop()) {
+                try {
+                    std::vector<std::vector<float>> embeddings = uint8Input
+                        ? clip_.encodeImageBatch(batch->tensorUint8, batch->indices.size())
+                        : clip_.encodeImageBatch(batch->tensor, batch->indices.size());
+                    for (size_t i = 0; i < batch->cacheKeys.size(); ++i) {
+                        clip_.cacheImage(batch->cacheKeys[i], embeddings[i]);
+                    }
+
+                    std::lock_guard<std::mutex> lock(callbackMutex);
+                    for (size_t i = 0; i < batch->indices.size(); ++i) {
+                        onResult(batch->indices[i], std::move(embeddings[i]));
+                    }
+                } catch (const std::exception& e) {
+                    for (size_t index : batch->indices) {
+                        reportError(index, e.what());
+                    }
+                }
+
+                // Hand batch buffers back to the decoders
+                utils::byteBufferPool().release(std::move(batch->tensorUint8));
+                utils::floatBufferPool().release(std::move(batch->tensor));
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(static_cast<size_t>(options_.decodeThreads + options_.inferenceThreads));
+        for (int i = 0; i < options_.decodeThreads; ++i) {
+            threads.emplace_back(decodeWorker);
+        }
+        for (int i = 0; i < options_.inferenceThreads; ++i) {
+            threads.emplace_back(inferenceWorker);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        clip_.flushImageCache();
+    }
+
+} // namespace pipeline
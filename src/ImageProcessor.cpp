@@ -1,7 +1,10 @@
 #include "../include/image/ImageProcessor.h"
 #include "../include/config/Config.h"
+#include "../include/utils/BufferPool.h"
+#include "../include/utils/FileUtils.h"
 #include <opencv2/opencv.hpp>
 #include <stdexcept>
+#include <algorithm>
 
 // Link OpenCV libraries
 #ifdef _DEBUG
@@ -38,35 +41,169 @@
 
 namespace image {
 
+    namespace {
+
+        // Preprocess whole image and every tile crop into one packed batch tensor
+        template <typename T, typename Preprocess>
+        std::vector<T> packViews(const cv::Mat& image, const std::vector<TileRect>& tiles, utils::BufferPool<T>& pool, Preprocess preprocess) {
+            const size_t viewSize = static_cast<size_t>(config::IMAGE_CHANNELS) * config::IMAGE_SIZE * config::IMAGE_SIZE;
+            std::vector<T> batch = pool.acquire((tiles.size() + 1) * viewSize);
+
+            for (size_t i = 0; i <= tiles.size(); ++i) {
+                std::vector<T> view = i == 0
+                    ? preprocess(image)
+                    : preprocess(image(cv::Rect(tiles[i - 1].x, tiles[i - 1].y, tiles[i - 1].width, tiles[i - 1].height)));
+                std::copy(view.begin(), view.end(), batch.begin() + i * viewSize);
+                pool.release(std::move(view));
+            }
+
+            return batch;
+        }
+
+    } // namespace
+
+    std::vector<TileRect> computeTileGrid(int width, int height, const TileOptions& options) {
+        const int grid = std::max(1, options.grid);
+        const float overlap = std::min(std::max(options.overlap, 0.0f), 0.9f);
+
+        // grid tiles with stride (1 - overlap) * tile cover the whole side
+        auto tileLength = [&](int side) {
+            return std::max(1, static_cast<int>(side / (grid - (grid - 1) * overlap) + 0.5f));
+        };
+        const int tileW = std::min(width, tileLength(width));
+        const int tileH = std::min(height, tileLength(height));
+
+        std::vector<TileRect> tiles;
+        tiles.reserve(static_cast<size_t>(grid) * grid);
+        for (int row = 0; row < grid; ++row) {
+            for (int col = 0; col < grid; ++col) {
+                // Spread tiles evenly so the last one ends exactly at the border
+                int x = grid > 1 ? (width - tileW) * col / (grid - 1) : 0;
+                int y = grid > 1 ? (height - tileH) * row / (grid - 1) : 0;
+                tiles.push_back({ x, y, tileW, tileH });
+            }
+        }
+
+        return tiles;
+    }
+
     ImageProcessor::ImageProcessor() = default;
     ImageProcessor::~ImageProcessor() = default;
 
-    std::vector<float> ImageProcessor::preprocessImage(const std::filesystem::path& imagePath) {
+    std::vector<float> ImageProcessor::preprocessImage(const std::filesystem::path& imagePath) const {
+        return preprocessImage(loadImage(imagePath));
+    }
+
+    std::vector<float> ImageProcessor::preprocessImage(const uint8_t* data, size_t size) const {
+        return preprocessImage(decodeImage(data, size));
+    }
+
+    std::vector<float> ImageProcessor::preprocessImage(const cv::Mat& image) const {
+        // Convert to tensor
+        return matToTensor(resizeToModelInput(image));
+    }
+
+    std::vector<uint8_t> ImageProcessor::preprocessImageUint8(const std::filesystem::path& imagePath, TensorLayout layout) const {
+        return preprocessImageUint8(loadImage(imagePath), layout);
+    }
+
+    std::vector<uint8_t> ImageProcessor::preprocessImageUint8(const uint8_t* data, size_t size, TensorLayout layout) const {
+        return preprocessImageUint8(decodeImage(data, size), layout);
+    }
+
+    std::vector<uint8_t> ImageProcessor::preprocessImageUint8(const cv::Mat& image, TensorLayout layout) const {
+        cv::Mat resized = resizeToModelInput(image);
+
+        const int h = resized.rows;
+        const int w = resized.cols;
+        const int c = resized.channels();
+        std::vector<uint8_t> tensor = utils::byteBufferPool().acquire(static_cast<size_t>(c) * h * w);
+
+        if (layout == TensorLayout::NHWC) {
+            // OpenCV already stores pixels as HWC, copy row by row
+            for (int y = 0; y < h; ++y) {
+                const uint8_t* row = resized.ptr<uint8_t>(y);
+                std::copy(row, row + static_cast<size_t>(w) * c, tensor.begin() + static_cast<size_t>(y) * w * c);
+            }
+            return tensor;
+        }
+
+        // Deinterleave HWC into CHW planes
+        const size_t planeSize = static_cast<size_t>(h) * w;
+        for (int y = 0; y < h; ++y) {
+            const uint8_t* row = resized.ptr<uint8_t>(y);
+            for (int x = 0; x < w; ++x) {
+                for (int ch = 0; ch < c; ++ch) {
+                    tensor[ch * planeSize + static_cast<size_t>(y) * w + x] = row[x * c + ch];
+                }
+            }
+        }
+
+        return tensor;
+    }
+
+    std::vector<float> ImageProcessor::preprocessImageTiled(const std::filesystem::path& imagePath, const TileOptions& options, std::vector<TileRect>& tiles) const {
+        cv::Mat image = loadImage(imagePath);
+        tiles = computeTileGrid(image.cols, image.rows, options);
+        return packViews(image, tiles, utils::floatBufferPool(), [this](const cv::Mat& view) {
+            return preprocessImage(view);
+        });
+    }
+
+    std::vector<uint8_t> ImageProcessor::preprocessImageTiledUint8(const std::filesystem::path& imagePath, const TileOptions& options, TensorLayout layout, std::vector<TileRect>& tiles) const {
+        cv::Mat image = loadImage(imagePath);
+        tiles = computeTileGrid(image.cols, image.rows, options);
+        return packViews(image, tiles, utils::byteBufferPool(), [this, layout](const cv::Mat& view) {
+            return preprocessImageUint8(view, layout);
+        });
+    }
+
+    cv::Mat ImageProcessor::loadImage(const std::filesystem::path& imagePath) const {
         cv::Mat image = cv::imread(imagePath.string(), cv::IMREAD_COLOR);
         if (image.empty()) {
             throw std::runtime_error("Failed to load image: " + imagePath.string());
         }
-        return preprocessImage(image);
+        return image;
     }
 
-    std::vector<float> ImageProcessor::preprocessImage(const cv::Mat& image) {
-        cv::Mat processed;
+    cv::Mat ImageProcessor::decodeImage(const uint8_t* data, size_t size) const {
+        if (data == nullptr || size == 0) {
+            throw std::runtime_error("Empty image buffer");
+        }
+
+        // Formats this build has no decoder for are recognized by content and reported as such;
+        // unknown signatures still go to imdecode, which knows a few more (PNM, JPEG 2000, ...)
+        utils::ImageFormat format = utils::sniffImageFormat(data, size);
+        if (format != utils::ImageFormat::Unknown && !utils::isDecodableImageFormat(format)) {
+            throw std::runtime_error(std::string("No decoder for ") + utils::imageFormatName(format) + " images in this build");
+        }
 
-        // Convert BGR to RGB
-        cv::cvtColor(image, processed, cv::COLOR_BGR2RGB);
+        // Wrap the bytes without copying; imdecode only reads them
+        cv::Mat buffer(1, static_cast<int>(size), CV_8UC1, const_cast<uint8_t*>(data));
+        cv::Mat image = cv::imdecode(buffer, cv::IMREAD_COLOR);
+        if (image.empty()) {
+            throw std::runtime_error("Failed to decode image from buffer of " + std::to_string(size) + " bytes");
+        }
+        return image;
+    }
 
-        // Resize to 224x224
-        cv::Mat resized;
-        cv::resize(processed, resized, cv::Size(config::IMAGE_SIZE, config::IMAGE_SIZE), 0, 0, cv::INTER_LINEAR);
+    cv::Mat ImageProcessor::resizeToModelInput(const cv::Mat& image) const {
+        // Per-thread scratch images; create() inside OpenCV reuses them since the size never changes
+        thread_local cv::Mat resized;
+        thread_local cv::Mat processed;
 
-        // Convert to tensor
-        return matToTensor(resized);
+        // Resize to 224x224 first, so the color conversion touches only the small image
+        cv::resize(image, resized, cv::Size(config::IMAGE_SIZE, config::IMAGE_SIZE), 0, 0, cv::INTER_LINEAR);
+
+        // Convert BGR to RGB
+        cv::cvtColor(resized, processed, cv::COLOR_BGR2RGB);
+        return processed;
     }
 
     std::vector<float> ImageProcessor::matToTensor(const cv::Mat& image) const {
         // Tensor shape: [1, 3, 224, 224]
         const int tensorSize = 1 * config::IMAGE_CHANNELS * config::IMAGE_SIZE * config::IMAGE_SIZE;
-        std::vector<float> tensor(tensorSize);
+        std::vector<float> tensor = utils::floatBufferPool().acquire(tensorSize);
 
         // OpenCV Mat is in HWC format (Height, Width, Channels)
         // We need CHW format (Channels, Height, Width)
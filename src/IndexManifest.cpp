@@ -0,0 +1,248 @@
+#include "../include/store/IndexManifest.h"
+#include "../include/store/EmbeddingStore.h"
+#include "../include/utils/Hash.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace store {
+
+    namespace {
+
+        constexpr char FILE_MAGIC[8] = { 'C', 'L', 'I', 'P', 'M', 'A', 'N', '\0' };
+        constexpr uint32_t FLAG_DELETED = 1;
+
+        struct FileHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t reserved;
+            uint64_t count;
+            uint64_t reserved2;
+        };
+        static_assert(sizeof(FileHeader) == 32, "Header must stay 32 bytes");
+
+        struct EntryHeader {
+            uint64_t size;
+            int64_t mtime;
+            uint64_t contentHash;
+            uint64_t row;
+            uint32_t flags;
+            uint32_t pathLength;
+        };
+        static_assert(sizeof(EntryHeader) == 40, "Entry header must stay 40 bytes");
+
+        std::string relativeKey(const std::filesystem::path& root, const std::filesystem::path& file) {
+            return file.lexically_relative(root).generic_string();
+        }
+
+        int64_t lastWriteTicks(const std::filesystem::path& file) {
+            return static_cast<int64_t>(std::filesystem::last_write_time(file).time_since_epoch().count());
+        }
+
+    } // namespace
+
+    ManifestUpdate IndexManifest::scan(const std::filesystem::path& root, const std::vector<std::filesystem::path>& files) {
+        ManifestUpdate update;
+        std::unordered_set<std::string> seen;
+        seen.reserve(files.size());
+
+        for (const auto& fullPath : files) {
+            std::string key = relativeKey(root, fullPath);
+            seen.insert(key);
+
+            const uint64_t size = std::filesystem::file_size(fullPath);
+            const int64_t mtime = lastWriteTicks(fullPath);
+
+            auto it = byPath_.find(key);
+            ManifestEntry* entry = it == byPath_.end() ? nullptr : &entries_[it->second];
+            if (entry && !entry->deleted && entry->row != ManifestEntry::NO_ROW && entry->size == size && entry->mtime == mtime) {
+                ++update.unchanged;
+                continue;
+            }
+
+            // Size or mtime differ: only a different content needs the encoder
+            const uint64_t contentHash = utils::hashFile(fullPath);
+            if (entry && !entry->deleted && entry->row != ManifestEntry::NO_ROW && entry->contentHash == contentHash) {
+                entry->size = size;
+                entry->mtime = mtime;
+                ++update.unchanged;
+                continue;
+            }
+
+            pending_[std::move(key)] = PendingFile{ size, mtime, contentHash };
+            update.changed.push_back(fullPath);
+        }
+
+        for (auto& entry : entries_) {
+            if (!entry.deleted && seen.count(entry.path) == 0) {
+                entry.deleted = true;
+                ++update.deleted;
+            }
+        }
+
+        return update;
+    }
+
+    std::string IndexManifest::key(const std::filesystem::path& root, const std::filesystem::path& file) {
+        return relativeKey(root, file);
+    }
+
+    void IndexManifest::commit(const std::filesystem::path& root, const std::filesystem::path& fullPath, uint64_t row) {
+        std::string key = relativeKey(root, fullPath);
+
+        ManifestEntry& entry = entryFor(key);
+        auto pending = pending_.find(key);
+        if (pending != pending_.end()) {
+            entry.size = pending->second.size;
+            entry.mtime = pending->second.mtime;
+            entry.contentHash = pending->second.contentHash;
+            pending_.erase(pending);
+        } else {
+            entry.size = std::filesystem::file_size(fullPath);
+            entry.mtime = lastWriteTicks(fullPath);
+            entry.contentHash = utils::hashFile(fullPath);
+        }
+        entry.row = row;
+        entry.deleted = false;
+    }
+
+    const ManifestEntry* IndexManifest::find(std::string_view path) const {
+        auto it = byPath_.find(std::string(path));
+        return it == byPath_.end() ? nullptr : &entries_[it->second];
+    }
+
+    std::vector<uint64_t> IndexManifest::liveRows() const {
+        std::vector<uint64_t> rows;
+        rows.reserve(entries_.size());
+        for (const auto& entry : entries_) {
+            if (!entry.deleted && entry.row != ManifestEntry::NO_ROW) {
+                rows.push_back(entry.row);
+            }
+        }
+        std::sort(rows.begin(), rows.end());
+        return rows;
+    }
+
+    bool IndexManifest::matches(const EmbeddingStore& store) const {
+        for (const auto& entry : entries_) {
+            if (entry.deleted || entry.row == ManifestEntry::NO_ROW) {
+                continue;
+            }
+            if (entry.row >= store.size() || store.id(static_cast<size_t>(entry.row)) != entry.path) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void IndexManifest::compact() {
+        std::vector<uint64_t> rows = liveRows();
+
+        std::vector<ManifestEntry> live;
+        live.reserve(rows.size());
+        for (auto& entry : entries_) {
+            if (!entry.deleted && entry.row != ManifestEntry::NO_ROW) {
+                entry.row = static_cast<uint64_t>(std::lower_bound(rows.begin(), rows.end(), entry.row) - rows.begin());
+                live.push_back(std::move(entry));
+            }
+        }
+
+        entries_ = std::move(live);
+        byPath_.clear();
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            byPath_[entries_[i].path] = i;
+        }
+    }
+
+    void IndexManifest::save(const std::filesystem::path& filePath) const {
+        FileHeader header{};
+        std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.version = FORMAT_VERSION;
+        header.count = entries_.size();
+
+        std::string buffer(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const auto& entry : entries_) {
+            EntryHeader record{ entry.size, entry.mtime, entry.contentHash, entry.row,
+                                entry.deleted ? FLAG_DELETED : 0u, static_cast<uint32_t>(entry.path.size()) };
+            buffer.append(reinterpret_cast<const char*>(&record), sizeof(record));
+            buffer.append(entry.path);
+        }
+
+        std::filesystem::path tempPath = filePath;
+        tempPath += ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                throw std::runtime_error("Failed to create file: " + tempPath.string());
+            }
+            file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            if (!file) {
+                throw std::runtime_error("Failed to write file: " + tempPath.string());
+            }
+        }
+        std::filesystem::rename(tempPath, filePath);
+    }
+
+    IndexManifest IndexManifest::load(const std::filesystem::path& filePath) {
+        IndexManifest manifest;
+        std::ifstream file(filePath, std::ios::binary);
+        if (!file.is_open()) {
+            return manifest;
+        }
+        std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        FileHeader header;
+        if (data.size() < sizeof(header)) {
+            throw std::runtime_error("Manifest file is truncated: " + filePath.string());
+        }
+        std::memcpy(&header, data.data(), sizeof(header));
+        if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+            throw std::runtime_error("Not an index manifest file: " + filePath.string());
+        }
+        if (header.version != FORMAT_VERSION) {
+            throw std::runtime_error("Unsupported index manifest version " + std::to_string(header.version) + ": " + filePath.string());
+        }
+
+        size_t offset = sizeof(header);
+        for (uint64_t i = 0; i < header.count; ++i) {
+            EntryHeader record;
+            if (data.size() - offset < sizeof(record)) {
+                throw std::runtime_error("Corrupted index manifest file: " + filePath.string());
+            }
+            std::memcpy(&record, data.data() + offset, sizeof(record));
+            offset += sizeof(record);
+            if (data.size() - offset < record.pathLength) {
+                throw std::runtime_error("Corrupted index manifest file: " + filePath.string());
+            }
+
+            ManifestEntry& entry = manifest.entryFor(std::string(data.data() + offset, record.pathLength));
+            entry.size = record.size;
+            entry.mtime = record.mtime;
+            entry.contentHash = record.contentHash;
+            entry.row = record.row;
+            entry.deleted = (record.flags & FLAG_DELETED) != 0;
+            offset += record.pathLength;
+        }
+
+        return manifest;
+    }
+
+    std::filesystem::path IndexManifest::pathFor(const std::filesystem::path& storePath) {
+        std::filesystem::path manifestPath = storePath;
+        manifestPath += ".manifest";
+        return manifestPath;
+    }
+
+    ManifestEntry& IndexManifest::entryFor(const std::string& path) {
+        auto [it, inserted] = byPath_.try_emplace(path, entries_.size());
+        if (inserted) {
+            entries_.push_back({});
+            entries_.back().path = path;
+        }
+        return entries_[it->second];
+    }
+
+} // namespace store
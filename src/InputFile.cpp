@@ -0,0 +1,65 @@
+#include "../include/utils/InputFile.h"
+#include <stdexcept>
+#include <string>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace utils {
+
+    InputFile::InputFile(const std::filesystem::path& filePath) : path_(filePath) {
+#ifdef _WIN32
+        stream_.open(filePath, std::ios::binary | std::ios::ate);
+        if (!stream_.is_open()) {
+            throw std::runtime_error("Failed to open file: " + filePath.string());
+        }
+        size_ = static_cast<size_t>(stream_.tellg());
+        stream_.seekg(0);
+#else
+        fd_ = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) {
+            throw std::runtime_error("Failed to open file: " + filePath.string());
+        }
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) {
+            ::close(fd_);
+            throw std::runtime_error("Failed to get file size: " + filePath.string());
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        // Whole-file sequential read: let the kernel use a large readahead window
+        ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    }
+
+    InputFile::~InputFile() {
+#ifndef _WIN32
+        ::close(fd_);
+#endif
+    }
+
+    void InputFile::readAll(uint8_t* out) {
+#ifdef _WIN32
+        stream_.read(reinterpret_cast<char*>(out), static_cast<std::streamsize>(size_));
+        if (!stream_) {
+            throw std::runtime_error("Failed to read file: " + path_.string());
+        }
+#else
+        size_t done = 0;
+        while (done < size_) {
+            ssize_t bytes = ::read(fd_, out + done, size_ - done);
+            if (bytes < 0 && errno == EINTR) {
+                continue;
+            }
+            if (bytes <= 0) {
+                throw std::runtime_error("Failed to read file: " + path_.string());
+            }
+            done += static_cast<size_t>(bytes);
+        }
+#endif
+    }
+
+} // namespace utils
@@ -0,0 +1,368 @@
+#include "../include/ann/IvfPqIndex.h"
+#include "../include/ann/KMeans.h"
+#include "../include/math/SimdKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+namespace ann {
+
+    namespace {
+
+        constexpr char FILE_MAGIC[8] = { 'C', 'L', 'I', 'P', 'I', 'V', 'F', 'P' };
+
+        struct FileHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t dim;
+            uint64_t count;
+            uint32_t lists;
+            uint32_t subspaces;
+            uint32_t iterations;
+            uint32_t seed;
+            uint32_t trained;
+            uint8_t reserved[20];
+        };
+        static_assert(sizeof(FileHeader) == 64, "Header must stay 64 bytes");
+
+        template <typename T>
+        void readExact(std::ifstream& file, T* data, size_t count, const std::filesystem::path& filePath) {
+            file.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+            if (!file) {
+                throw std::runtime_error("IVF-PQ index file is truncated: " + filePath.string());
+            }
+        }
+
+        // Copy of rows scaled to unit length, so inner product equals cosine
+        math::Matrix normalizedCopy(const math::MatrixView& vectors) {
+            math::Matrix result = math::Matrix::fromView(vectors);
+            math::normalizeRows(result);
+            return result;
+        }
+
+        // Codebooks are low-dimensional and there are many of them; 64 points per codeword keep training time in check
+        constexpr size_t PQ_SAMPLES_PER_CODEWORD = 64;
+
+    } // namespace
+
+    IvfPqIndex::IvfPqIndex(size_t dim, IvfPqOptions options)
+        : dim_(dim),
+          options_(options),
+          trained_(false),
+          count_(0) {
+        if (options_.lists == 0 || options_.subspaces == 0 || dim_ % options_.subspaces != 0) {
+            throw std::runtime_error("IVF-PQ subspace count must divide the embedding dimension");
+        }
+    }
+
+    void IvfPqIndex::train(const math::MatrixView& samples) {
+        if (samples.cols != dim_) {
+            throw std::runtime_error("Training vector dimension does not match IVF-PQ index");
+        }
+        if (samples.rows < std::max(options_.lists, CODEBOOK_SIZE)) {
+            throw std::runtime_error("IVF-PQ training needs at least max(lists, 256) samples");
+        }
+
+        KMeansOptions kmeans;
+        kmeans.iterations = options_.iterations;
+        kmeans.seed = options_.seed;
+
+        math::Matrix data = normalizedCopy(samples);
+        centroids_ = trainKMeans(data, options_.lists, kmeans);
+
+        // Codebooks are trained on residuals to the coarse centroids
+        std::vector<uint32_t> assignment = assignNearest(data, centroids_);
+        for (size_t i = 0; i < data.rows(); ++i) {
+            float* row = data.row(i);
+            const float* centroid = centroids_.row(assignment[i]);
+            for (size_t c = 0; c < dim_; ++c) {
+                row[c] -= centroid[c];
+            }
+        }
+
+        const size_t dsub = subspaceDim();
+        codebooks_ = math::Matrix(options_.subspaces * CODEBOOK_SIZE, dsub);
+        math::Matrix sub(data.rows(), dsub);
+        for (size_t s = 0; s < options_.subspaces; ++s) {
+            for (size_t i = 0; i < data.rows(); ++i) {
+                std::copy(data.row(i) + s * dsub, data.row(i) + (s + 1) * dsub, sub.row(i));
+            }
+            kmeans.seed = options_.seed + static_cast<uint32_t>(s) + 1;
+            kmeans.maxSamplesPerCentroid = PQ_SAMPLES_PER_CODEWORD;
+            math::Matrix codebook = trainKMeans(sub, CODEBOOK_SIZE, kmeans);
+            std::copy(codebook.data(), codebook.data() + CODEBOOK_SIZE * dsub, codebooks_.row(s * CODEBOOK_SIZE));
+        }
+
+        buildCodebookColumns();
+        lists_.assign(options_.lists, InvertedList());
+        count_ = 0;
+        trained_ = true;
+    }
+
+    void IvfPqIndex::buildCodebookColumns() {
+        const size_t dsub = subspaceDim();
+        codebookColumns_ = math::Matrix(dim_, CODEBOOK_SIZE);
+        for (size_t s = 0; s < options_.subspaces; ++s) {
+            for (size_t j = 0; j < CODEBOOK_SIZE; ++j) {
+                const float* codeword = codebooks_.row(s * CODEBOOK_SIZE + j);
+                for (size_t c = 0; c < dsub; ++c) {
+                    codebookColumns_(s * dsub + c, j) = codeword[c];
+                }
+            }
+        }
+    }
+
+    void IvfPqIndex::appendCode(InvertedList& list, uint32_t id, const uint8_t* code) const {
+        const size_t position = list.ids.size();
+        const size_t blockBytes = options_.subspaces * BLOCK_SIZE;
+        if (position % BLOCK_SIZE == 0) {
+            list.codes.resize(list.codes.size() + blockBytes, 0);
+        }
+
+        uint8_t* block = list.codes.data() + (position / BLOCK_SIZE) * blockBytes;
+        for (size_t s = 0; s < options_.subspaces; ++s) {
+            block[s * BLOCK_SIZE + position % BLOCK_SIZE] = code[s];
+        }
+        list.ids.push_back(id);
+    }
+
+    void IvfPqIndex::add(const math::MatrixView& vectors) {
+        if (!trained_) {
+            throw std::runtime_error("IVF-PQ index must be trained before adding vectors");
+        }
+        if (vectors.cols != dim_ && !vectors.empty()) {
+            throw std::runtime_error("Vector dimension does not match IVF-PQ index");
+        }
+
+        math::Matrix data = normalizedCopy(vectors);
+        std::vector<uint32_t> assignment = assignNearest(data, centroids_);
+        for (size_t i = 0; i < data.rows(); ++i) {
+            float* row = data.row(i);
+            const float* centroid = centroids_.row(assignment[i]);
+            for (size_t c = 0; c < dim_; ++c) {
+                row[c] -= centroid[c];
+            }
+        }
+
+        // Encode every subspace of all rows with one GEMM-backed assignment
+        const size_t dsub = subspaceDim();
+        const size_t subspaces = options_.subspaces;
+        std::vector<uint8_t> codes(data.rows() * subspaces);
+        math::Matrix sub(data.rows(), dsub);
+        for (size_t s = 0; s < subspaces; ++s) {
+            for (size_t i = 0; i < data.rows(); ++i) {
+                std::copy(data.row(i) + s * dsub, data.row(i) + (s + 1) * dsub, sub.row(i));
+            }
+            std::vector<uint32_t> nearest = assignNearest(sub, { codebooks_.row(s * CODEBOOK_SIZE), CODEBOOK_SIZE, dsub });
+            for (size_t i = 0; i < data.rows(); ++i) {
+                codes[i * subspaces + s] = static_cast<uint8_t>(nearest[i]);
+            }
+        }
+
+        for (size_t i = 0; i < data.rows(); ++i) {
+            appendCode(lists_[assignment[i]], static_cast<uint32_t>(count_ + i), codes.data() + i * subspaces);
+        }
+        count_ += data.rows();
+    }
+
+    std::vector<math::ScoredIndex> IvfPqIndex::search(const float* query, size_t k, const IvfPqSearchOptions& options) const {
+        std::vector<math::ScoredIndex> heap;
+        if (!trained_ || count_ == 0 || k == 0) {
+            return heap;
+        }
+
+        const bool rerank = options.rerank > 0 && options.vectors.data != nullptr;
+        if (rerank && (options.vectors.cols != dim_ || options.vectors.rows < count_)) {
+            throw std::runtime_error("Re-ranking vectors do not match IVF-PQ index");
+        }
+
+        thread_local std::vector<float> q;
+        q.assign(query, query + dim_);
+        math::normalize(q.data(), dim_);
+
+        // Lists whose centroids score highest against the query
+        const size_t nprobe = std::min(std::max<size_t>(options.nprobe, 1), options_.lists);
+        std::vector<math::ScoredIndex> coarse(options_.lists);
+        for (size_t j = 0; j < options_.lists; ++j) {
+            coarse[j] = { static_cast<uint32_t>(j), math::dotProduct(q.data(), centroids_.row(j), dim_) };
+        }
+        std::partial_sort(coarse.begin(), coarse.begin() + nprobe, coarse.end(), math::betterMatch);
+
+        // Query-to-codeword table: lut[s * 256 + j] = q_s . codebook[s][j]
+        // Accumulated over the transposed codebooks so the inner loop runs along 256 contiguous codewords
+        thread_local std::vector<float> lut;
+        lut.assign(options_.subspaces * CODEBOOK_SIZE, 0.0f);
+        for (size_t c = 0; c < dim_; ++c) {
+            const float qc = q[c];
+            const float* column = codebookColumns_.row(c);
+            float* table = lut.data() + (c / subspaceDim()) * CODEBOOK_SIZE;
+            for (size_t j = 0; j < CODEBOOK_SIZE; ++j) {
+                table[j] += qc * column[j];
+            }
+        }
+
+        // Bounded heap with the worst kept match on top
+        const size_t keep = rerank ? std::max(k, options.rerank) : k;
+        heap.reserve(keep + 1);
+        thread_local std::vector<float> scores;
+
+        for (size_t p = 0; p < nprobe; ++p) {
+            const InvertedList& list = lists_[coarse[p].index];
+            if (list.ids.empty()) {
+                continue;
+            }
+
+            const size_t blocks = (list.ids.size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+            scores.resize(blocks * BLOCK_SIZE);
+            math::pqScanBlocks(lut.data(), list.codes.data(), blocks, options_.subspaces, scores.data());
+
+            for (size_t i = 0; i < list.ids.size(); ++i) {
+                math::pushBounded(heap, keep, { list.ids[i], coarse[p].score + scores[i] });
+            }
+        }
+
+        if (rerank) {
+            for (auto& candidate : heap) {
+                const float* row = options.vectors.row(candidate.index);
+                float norm = std::sqrt(math::squaredL2Norm(row, dim_));
+                float dot = math::dotProduct(q.data(), row, dim_);
+                candidate.score = norm > 0.0f ? dot / norm : 0.0f;
+            }
+        }
+
+        std::sort(heap.begin(), heap.end(), math::betterMatch);
+        if (heap.size() > k) {
+            heap.resize(k);
+        }
+        return heap;
+    }
+
+    math::TopK IvfPqIndex::search(const math::MatrixView& queries, size_t k, const IvfPqSearchOptions& options) const {
+        if (queries.cols != dim_ && !queries.empty()) {
+            throw std::runtime_error("Query dimension does not match IVF-PQ index");
+        }
+
+        math::TopK result;
+        result.rows = queries.rows;
+        result.k = std::min(k, count_);
+        result.entries.resize(result.rows * result.k, { 0, 0.0f });
+
+        for (size_t i = 0; i < queries.rows; ++i) {
+            std::vector<math::ScoredIndex> matches = search(queries.row(i), result.k, options);
+            std::copy(matches.begin(), matches.end(), result.entries.begin() + i * result.k);
+        }
+
+        return result;
+    }
+
+    size_t IvfPqIndex::codeBytes() const {
+        size_t bytes = 0;
+        for (const auto& list : lists_) {
+            bytes += list.ids.size() * sizeof(uint32_t) + list.codes.size();
+        }
+        return bytes;
+    }
+
+    void IvfPqIndex::save(const std::filesystem::path& filePath) const {
+        FileHeader header{};
+        std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.version = FORMAT_VERSION;
+        header.dim = static_cast<uint32_t>(dim_);
+        header.count = count_;
+        header.lists = static_cast<uint32_t>(options_.lists);
+        header.subspaces = static_cast<uint32_t>(options_.subspaces);
+        header.iterations = static_cast<uint32_t>(options_.iterations);
+        header.seed = options_.seed;
+        header.trained = trained_ ? 1 : 0;
+
+        std::filesystem::path tempPath = filePath;
+        tempPath += ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                throw std::runtime_error("Failed to create file: " + tempPath.string());
+            }
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            if (trained_) {
+                file.write(reinterpret_cast<const char*>(centroids_.data()), static_cast<std::streamsize>(centroids_.rows() * dim_ * sizeof(float)));
+                file.write(reinterpret_cast<const char*>(codebooks_.data()), static_cast<std::streamsize>(codebooks_.rows() * codebooks_.cols() * sizeof(float)));
+                for (const auto& list : lists_) {
+                    uint64_t size = list.ids.size();
+                    file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+                    file.write(reinterpret_cast<const char*>(list.ids.data()), static_cast<std::streamsize>(list.ids.size() * sizeof(uint32_t)));
+                    file.write(reinterpret_cast<const char*>(list.codes.data()), static_cast<std::streamsize>(list.codes.size()));
+                }
+            }
+
+            if (!file) {
+                throw std::runtime_error("Failed to write file: " + tempPath.string());
+            }
+        }
+
+        std::filesystem::rename(tempPath, filePath);
+    }
+
+    IvfPqIndex IvfPqIndex::load(const std::filesystem::path& filePath) {
+        std::ifstream file(filePath, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file: " + filePath.string());
+        }
+
+        FileHeader header;
+        readExact(file, &header, 1, filePath);
+        if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+            throw std::runtime_error("Not an IVF-PQ index file: " + filePath.string());
+        }
+        if (header.version != FORMAT_VERSION) {
+            throw std::runtime_error("Unsupported IVF-PQ index version " + std::to_string(header.version) + ": " + filePath.string());
+        }
+
+        IvfPqOptions options;
+        options.lists = header.lists;
+        options.subspaces = header.subspaces;
+        options.iterations = header.iterations;
+        options.seed = header.seed;
+
+        IvfPqIndex index(header.dim, options);
+        if (header.trained == 0) {
+            return index;
+        }
+
+        index.centroids_ = math::Matrix(options.lists, index.dim_);
+        readExact(file, index.centroids_.data(), options.lists * index.dim_, filePath);
+        index.codebooks_ = math::Matrix(options.subspaces * CODEBOOK_SIZE, index.subspaceDim());
+        readExact(file, index.codebooks_.data(), options.subspaces * CODEBOOK_SIZE * index.subspaceDim(), filePath);
+
+        index.lists_.resize(options.lists);
+        size_t total = 0;
+        for (auto& list : index.lists_) {
+            uint64_t size = 0;
+            readExact(file, &size, 1, filePath);
+            if (size > header.count) {
+                throw std::runtime_error("Corrupted IVF-PQ index file: " + filePath.string());
+            }
+            list.ids.resize(static_cast<size_t>(size));
+            readExact(file, list.ids.data(), list.ids.size(), filePath);
+            list.codes.resize((list.ids.size() + BLOCK_SIZE - 1) / BLOCK_SIZE * options.subspaces * BLOCK_SIZE);
+            readExact(file, list.codes.data(), list.codes.size(), filePath);
+
+            if (std::any_of(list.ids.begin(), list.ids.end(), [&header](uint32_t id) { return id >= header.count; })) {
+                throw std::runtime_error("Corrupted IVF-PQ index file: " + filePath.string());
+            }
+            total += list.ids.size();
+        }
+        if (total != header.count) {
+            throw std::runtime_error("Corrupted IVF-PQ index file: " + filePath.string());
+        }
+
+        index.buildCodebookColumns();
+        index.count_ = total;
+        index.trained_ = true;
+        return index;
+    }
+
+} // namespace ann
@@ -0,0 +1,130 @@
+#include "../include/ann/KMeans.h"
+#include "../include/math/Similarity.h"
+#include "../include/math/SimdKernels.h"
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+namespace ann {
+
+    namespace {
+
+        // Rows per GEMM call while assigning, bounds the score buffer to ASSIGN_BLOCK x k
+        constexpr size_t ASSIGN_BLOCK = 1024;
+
+    } // namespace
+
+    std::vector<uint32_t> assignNearest(const math::MatrixView& data, const math::MatrixView& centroids) {
+        if (data.cols != centroids.cols) {
+            throw std::runtime_error("Data and centroid dimensions must match");
+        }
+
+        std::vector<uint32_t> assignment(data.rows, 0);
+        if (data.rows == 0 || centroids.rows == 0) {
+            return assignment;
+        }
+
+        // argmin |x - c|^2 = argmax (x . c - |c|^2 / 2)
+        std::vector<float> halfNorms(centroids.rows);
+        for (size_t j = 0; j < centroids.rows; ++j) {
+            halfNorms[j] = 0.5f * math::squaredL2Norm(centroids.row(j), centroids.cols);
+        }
+
+        math::Matrix scores;
+        for (size_t i0 = 0; i0 < data.rows; i0 += ASSIGN_BLOCK) {
+            const size_t rows = std::min(ASSIGN_BLOCK, data.rows - i0);
+            math::matmulTransposed({ data.row(i0), rows, data.cols }, centroids, scores);
+
+            for (size_t i = 0; i < rows; ++i) {
+                const float* row = scores.row(i);
+                uint32_t best = 0;
+                float bestScore = row[0] - halfNorms[0];
+                for (size_t j = 1; j < centroids.rows; ++j) {
+                    float score = row[j] - halfNorms[j];
+                    if (score > bestScore) {
+                        bestScore = score;
+                        best = static_cast<uint32_t>(j);
+                    }
+                }
+                assignment[i0 + i] = best;
+            }
+        }
+
+        return assignment;
+    }
+
+    math::Matrix trainKMeans(const math::MatrixView& data, size_t k, const KMeansOptions& options) {
+        if (k == 0 || data.rows < k) {
+            throw std::runtime_error("k-means needs at least k training points");
+        }
+
+        std::mt19937 rng(options.seed);
+        const size_t d = data.cols;
+
+        // Subsample large training sets
+        math::Matrix samples;
+        const size_t maxSamples = std::max(k, k * options.maxSamplesPerCentroid);
+        if (data.rows > maxSamples) {
+            std::vector<size_t> order(data.rows);
+            std::iota(order.begin(), order.end(), 0);
+            std::shuffle(order.begin(), order.end(), rng);
+            samples = math::Matrix(maxSamples, d);
+            for (size_t i = 0; i < maxSamples; ++i) {
+                std::copy(data.row(order[i]), data.row(order[i]) + d, samples.row(i));
+            }
+        } else {
+            samples = math::Matrix::fromView(data);
+        }
+        const size_t n = samples.rows();
+
+        // Initial centroids are k distinct random samples
+        std::vector<size_t> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), rng);
+        math::Matrix centroids(k, d);
+        for (size_t j = 0; j < k; ++j) {
+            std::copy(samples.row(order[j]), samples.row(order[j]) + d, centroids.row(j));
+        }
+
+        std::vector<uint32_t> assignment;
+        std::vector<size_t> counts(k);
+        std::uniform_int_distribution<size_t> pickSample(0, n - 1);
+
+        for (size_t iteration = 0; iteration < options.iterations; ++iteration) {
+            std::vector<uint32_t> next = assignNearest(samples, centroids);
+            if (next == assignment) {
+                break;
+            }
+            assignment = std::move(next);
+
+            // Recompute centroids as cluster means
+            centroids = math::Matrix(k, d);
+            std::fill(counts.begin(), counts.end(), 0);
+            for (size_t i = 0; i < n; ++i) {
+                float* centroid = centroids.row(assignment[i]);
+                const float* sample = samples.row(i);
+                for (size_t c = 0; c < d; ++c) {
+                    centroid[c] += sample[c];
+                }
+                ++counts[assignment[i]];
+            }
+
+            for (size_t j = 0; j < k; ++j) {
+                float* centroid = centroids.row(j);
+                if (counts[j] == 0) {
+                    const float* sample = samples.row(pickSample(rng));
+                    std::copy(sample, sample + d, centroid);
+                    continue;
+                }
+                const float scale = 1.0f / static_cast<float>(counts[j]);
+                for (size_t c = 0; c < d; ++c) {
+                    centroid[c] *= scale;
+                }
+            }
+        }
+
+        return centroids;
+    }
+
+} // namespace ann
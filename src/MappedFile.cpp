@@ -0,0 +1,108 @@
+#include "../include/utils/MappedFile.h"
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace utils {
+
+#ifdef _WIN32
+
+    MappedFile::MappedFile(const std::filesystem::path& filePath)
+        : data_(nullptr), size_(0), fileHandle_(INVALID_HANDLE_VALUE), mappingHandle_(nullptr) {
+
+        fileHandle_ = CreateFileW(filePath.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle_ == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Failed to open file for mapping: " + filePath.string());
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(fileHandle_, &fileSize)) {
+            CloseHandle(fileHandle_);
+            throw std::runtime_error("Failed to get file size: " + filePath.string());
+        }
+        size_ = static_cast<size_t>(fileSize.QuadPart);
+
+        // Zero-length files cannot be mapped, leave data_ null
+        if (size_ == 0) {
+            return;
+        }
+
+        mappingHandle_ = CreateFileMappingW(fileHandle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle_ == nullptr) {
+            CloseHandle(fileHandle_);
+            throw std::runtime_error("Failed to create file mapping: " + filePath.string());
+        }
+
+        data_ = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle_, FILE_MAP_READ, 0, 0, 0));
+        if (data_ == nullptr) {
+            CloseHandle(mappingHandle_);
+            CloseHandle(fileHandle_);
+            throw std::runtime_error("Failed to map file: " + filePath.string());
+        }
+    }
+
+    MappedFile::~MappedFile() {
+        if (data_ != nullptr) {
+            UnmapViewOfFile(data_);
+        }
+        if (mappingHandle_ != nullptr) {
+            CloseHandle(mappingHandle_);
+        }
+        if (fileHandle_ != INVALID_HANDLE_VALUE) {
+            CloseHandle(fileHandle_);
+        }
+    }
+
+#else
+
+    MappedFile::MappedFile(const std::filesystem::path& filePath)
+        : data_(nullptr), size_(0), fd_(-1) {
+
+        fd_ = ::open(filePath.c_str(), O_RDONLY);
+        if (fd_ < 0) {
+            throw std::runtime_error("Failed to open file for mapping: " + filePath.string());
+        }
+
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) {
+            ::close(fd_);
+            throw std::runtime_error("Failed to get file size: " + filePath.string());
+        }
+        size_ = static_cast<size_t>(st.st_size);
+
+        // Zero-length files cannot be mapped, leave data_ null
+        if (size_ == 0) {
+            return;
+        }
+
+        void* mapped = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd_);
+            throw std::runtime_error("Failed to map file: " + filePath.string());
+        }
+        data_ = static_cast<const uint8_t*>(mapped);
+    }
+
+    MappedFile::~MappedFile() {
+        if (data_ != nullptr) {
+            ::munmap(const_cast<uint8_t*>(data_), size_);
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+#endif
+
+} // namespace utils
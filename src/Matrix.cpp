@@ -0,0 +1,51 @@
+#include "../include/math/Matrix.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace math {
+
+    Matrix Matrix::fromRows(const std::vector<std::vector<float>>& rows) {
+        if (rows.empty()) {
+            return Matrix();
+        }
+
+        Matrix result(rows.size(), rows.front().size());
+        for (size_t i = 0; i < rows.size(); ++i) {
+            if (rows[i].size() != result.cols_) {
+                throw std::runtime_error("All rows must have the same length");
+            }
+            std::copy(rows[i].begin(), rows[i].end(), result.row(i));
+        }
+
+        return result;
+    }
+
+    Matrix Matrix::fromView(const MatrixView& view) {
+        Matrix result(view.rows, view.cols);
+        if (!view.empty()) {
+            std::copy(view.data, view.data + view.rows * view.cols, result.data());
+        }
+        return result;
+    }
+
+    std::vector<std::vector<float>> Matrix::toRows() const {
+        std::vector<std::vector<float>> result;
+        result.reserve(rows_);
+        for (size_t i = 0; i < rows_; ++i) {
+            result.emplace_back(row(i), row(i) + cols_);
+        }
+        return result;
+    }
+
+    void Matrix::appendRow(const float* values, size_t size) {
+        if (rows_ == 0 && data_.empty()) {
+            cols_ = size;
+        } else if (size != cols_) {
+            throw std::runtime_error("Row length does not match matrix columns");
+        }
+
+        data_.insert(data_.end(), values, values + size);
+        ++rows_;
+    }
+
+} // namespace math
@@ -2,6 +2,7 @@
 #define _CRT_SECURE_NO_WARNINGS
 #include <stdexcept>
 #include <cstring>
+#include <algorithm>
 
 namespace onnx {
 
@@ -43,10 +44,13 @@ namespace onnx {
         }
     }
 
-    std::vector<float> ONNXSession::run(const std::string& inputName, const std::vector<float>& input) {
+    std::vector<float> ONNXSession::run(const std::string& inputName, const std::vector<float>& input, int64_t batchSize) {
         // Create input tensor
-        std::vector<int64_t> inputShape = {1, 3, 224, 224}; // [batch, channels, height, width]
+        std::vector<int64_t> inputShape = {batchSize, 3, 224, 224}; // [batch, channels, height, width]
         size_t inputTensorSize = input.size();
+        if (batchSize <= 0 || inputTensorSize != static_cast<size_t>(batchSize) * 3 * 224 * 224) {
+            throw std::runtime_error("Input tensor size does not match batch shape");
+        }
         
         auto memoryInfo = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
         Ort::Value inputTensor = Ort::Value::CreateTensor<float>(
@@ -70,8 +74,8 @@ namespace onnx {
             outputSize *= dim;
         }
 
-        std::vector<float> result(floatArray, floatArray + outputSize);
-        return result;
+        // Plain vector: single-image outputs are returned to callers as the embedding and kept
+        return std::vector<float>(floatArray, floatArray + outputSize);
     }
 
     std::vector<float> ONNXSession::run(const std::string& inputName, const std::vector<int32_t>& input) {
@@ -101,8 +105,45 @@ namespace onnx {
             outputSize *= dim;
         }
 
-        std::vector<float> result(floatArray, floatArray + outputSize);
-        return result;
+        // Plain vector: single-image outputs are returned to callers as the embedding and kept
+        return std::vector<float>(floatArray, floatArray + outputSize);
+    }
+
+    std::vector<float> ONNXSession::run(const std::string& inputName, const std::vector<uint8_t>& input, const std::vector<int64_t>& inputShape) {
+        // Create input tensor
+        size_t inputTensorSize = input.size();
+        size_t expectedSize = 1;
+        for (auto dim : inputShape) {
+            expectedSize *= static_cast<size_t>(dim);
+        }
+        if (inputShape.empty() || inputTensorSize != expectedSize) {
+            throw std::runtime_error("Input tensor size does not match shape");
+        }
+
+        auto memoryInfo = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+        Ort::Value inputTensor = Ort::Value::CreateTensor<uint8_t>(
+            memoryInfo, const_cast<uint8_t*>(input.data()), inputTensorSize,
+            inputShape.data(), inputShape.size()
+        );
+
+        // Run inference
+        const char* inputNames[] = {inputName.c_str()};
+        const char* outputNames[] = {outputNames_[0]};
+
+        auto outputTensors = session_.Run(Ort::RunOptions{nullptr},
+            inputNames, &inputTensor, 1,
+            outputNames, 1);
+
+        // Extract output
+        float* floatArray = outputTensors.front().GetTensorMutableData<float>();
+        auto outputShape = outputTensors.front().GetTensorTypeAndShapeInfo().GetShape();
+        size_t outputSize = 1;
+        for (auto dim : outputShape) {
+            outputSize *= dim;
+        }
+
+        // Plain vector: single-image outputs are returned to callers as the embedding and kept
+        return std::vector<float>(floatArray, floatArray + outputSize);
     }
 
     std::string ONNXSession::getInputName(size_t index) const {
@@ -119,5 +160,19 @@ namespace onnx {
         return std::string(outputNames_[index]);
     }
 
+    ONNXTensorElementDataType ONNXSession::getInputElementType(size_t index) const {
+        if (index >= inputNames_.size()) {
+            throw std::runtime_error("Input index out of range");
+        }
+        return session_.GetInputTypeInfo(index).GetTensorTypeAndShapeInfo().GetElementType();
+    }
+
+    std::vector<int64_t> ONNXSession::getInputShape(size_t index) const {
+        if (index >= inputNames_.size()) {
+            throw std::runtime_error("Input index out of range");
+        }
+        return session_.GetInputTypeInfo(index).GetTensorTypeAndShapeInfo().GetShape();
+    }
+
 } // namespace onnx
 
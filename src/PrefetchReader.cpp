@@ -0,0 +1,143 @@
+#include "../include/pipeline/PrefetchReader.h"
+#include "../include/utils/BufferPool.h"
+#include "../include/utils/InputFile.h"
+#include <algorithm>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace pipeline {
+
+    namespace {
+
+        // Ask the OS to start reading file into the page cache; best effort
+        void adviseWillNeed(const std::filesystem::path& filePath) {
+#ifndef _WIN32
+            int fd = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd >= 0) {
+                ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+                ::close(fd);
+            }
+#else
+            (void)filePath;
+#endif
+        }
+
+    } // namespace
+
+    PrefetchReader::PrefetchReader(const std::vector<std::filesystem::path>& paths, const PrefetchOptions& options)
+        : paths_(paths),
+          options_(options),
+          nextIndex_(0),
+          bytesInFlight_(0),
+          delivered_(0),
+          stopping_(false) {
+        options_.threads = std::max(1, options_.threads);
+
+        // Hint the files the readers will start with
+        for (size_t i = 0; i < std::min(options_.adviseAhead, paths_.size()); ++i) {
+            adviseWillNeed(paths_[i]);
+        }
+
+        readers_.reserve(static_cast<size_t>(options_.threads));
+        for (int i = 0; i < options_.threads; ++i) {
+            readers_.emplace_back(&PrefetchReader::readerLoop, this);
+        }
+    }
+
+    PrefetchReader::~PrefetchReader() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        budgetFreed_.notify_all();
+        for (auto& reader : readers_) {
+            reader.join();
+        }
+        for (auto& file : ready_) {
+            utils::byteBufferPool().release(std::move(file.data));
+        }
+    }
+
+    std::optional<EncodedImage> PrefetchReader::next() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        fileReady_.wait(lock, [this] { return !ready_.empty() || delivered_ == paths_.size(); });
+        if (ready_.empty()) {
+            return std::nullopt;
+        }
+
+        EncodedImage file = std::move(ready_.front());
+        ready_.pop_front();
+        ++delivered_;
+        bytesInFlight_ -= file.data.capacity();
+        budgetFreed_.notify_all();
+        if (delivered_ == paths_.size()) {
+            // Wake other decoders waiting for a file that will not come
+            fileReady_.notify_all();
+        }
+        return file;
+    }
+
+    void PrefetchReader::readerLoop() {
+        while (true) {
+            const size_t index = nextIndex_.fetch_add(1);
+            if (index >= paths_.size()) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (stopping_) {
+                    return;
+                }
+            }
+            if (options_.adviseAhead > 0 && index + options_.adviseAhead < paths_.size()) {
+                adviseWillNeed(paths_[index + options_.adviseAhead]);
+            }
+
+            EncodedImage file{ index, {}, {} };
+            try {
+                utils::InputFile input(paths_[index]);
+
+                // Wait until the decoders caught up; an oversized file goes through alone
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    budgetFreed_.wait(lock, [&] {
+                        return stopping_ || bytesInFlight_ == 0 || bytesInFlight_ + input.size() <= options_.maxBytesInFlight;
+                    });
+                    if (stopping_) {
+                        return;
+                    }
+                    bytesInFlight_ += input.size();
+                }
+
+                // The budget counts buffer capacity, which for a recycled buffer exceeds the file size
+                size_t reserved = input.size();
+                try {
+                    file.data = utils::byteBufferPool().acquire(input.size());
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        bytesInFlight_ += file.data.capacity() - reserved;
+                        reserved = file.data.capacity();
+                    }
+                    input.readAll(file.data.data());
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    bytesInFlight_ -= reserved;
+                    throw;
+                }
+            } catch (const std::exception& e) {
+                utils::byteBufferPool().release(std::move(file.data));
+                file.data.clear();
+                file.error = e.what();
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            ready_.push_back(std::move(file));
+            fileReady_.notify_one();
+        }
+    }
+
+} // namespace pipeline
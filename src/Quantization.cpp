@@ -0,0 +1,381 @@
+#include "../include/math/Quantization.h"
+#include "../include/math/SimdKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+namespace math {
+
+    namespace {
+
+        // Score every corpus row of every query with score(queryRow, corpusRow) and keep the best k
+        template <typename ScoreQuery>
+        TopK scanTopK(size_t queryRows, size_t corpusRows, size_t k, ScoreQuery&& scoreQuery) {
+            TopK result;
+            result.rows = queryRows;
+            result.k = std::min(k, corpusRows);
+            result.entries.resize(result.rows * result.k, { 0, 0.0f });
+            if (result.k == 0) {
+                return result;
+            }
+
+            std::vector<ScoredIndex> heap;
+            heap.reserve(result.k);
+            for (size_t i = 0; i < queryRows; ++i) {
+                heap.clear();
+                scoreQuery(i, [&heap, &result](uint32_t index, float score) {
+                    pushBounded(heap, result.k, { index, score });
+                });
+                std::sort_heap(heap.begin(), heap.end(), betterMatch);
+                std::copy(heap.begin(), heap.end(), result.entries.begin() + i * result.k);
+            }
+
+            return result;
+        }
+
+        Matrix transpose(const MatrixView& m) {
+            Matrix result(m.cols, m.rows);
+            for (size_t i = 0; i < m.rows; ++i) {
+                for (size_t j = 0; j < m.cols; ++j) {
+                    result(j, i) = m(i, j);
+                }
+            }
+            return result;
+        }
+
+        float frobeniusDistance(const Matrix& a, const Matrix& b) {
+            double sum = 0.0;
+            for (size_t i = 0; i < a.rows() * a.cols(); ++i) {
+                double diff = a.data()[i] - b.data()[i];
+                sum += diff * diff;
+            }
+            return static_cast<float>(std::sqrt(sum));
+        }
+
+        // Orthogonal polar factor U * W^T of m = U * S * W^T by Newton-Schulz iteration X <- X * (3I - X^T X) / 2
+        // Only matrix products, so it runs on the blocked GEMM; converges while singular values of X stay below sqrt(3)
+        Matrix orthogonalPolarFactor(const Matrix& m) {
+            const size_t d = m.rows();
+            Matrix x = m;
+            const float norm = std::sqrt(squaredL2Norm(m.data(), d * d));
+            if (norm == 0.0f) {
+                throw std::runtime_error("Cannot orthogonalize a zero matrix");
+            }
+            for (size_t i = 0; i < d * d; ++i) {
+                x.data()[i] /= norm;
+            }
+
+            Matrix gram;
+            Matrix product;
+            for (size_t iteration = 0; iteration < 100; ++iteration) {
+                // product = (X X^T) X, same as X (X^T X)
+                matmulTransposed(x, x, gram);
+                matmulTransposed(gram, transpose(x), product);
+
+                Matrix next(d, d);
+                for (size_t i = 0; i < d * d; ++i) {
+                    next.data()[i] = 1.5f * x.data()[i] - 0.5f * product.data()[i];
+                }
+                const float change = frobeniusDistance(next, x);
+                x = std::move(next);
+                if (change < 1e-5f * std::sqrt(static_cast<float>(d))) {
+                    break;
+                }
+            }
+
+            return x;
+        }
+
+    } // namespace
+
+    float quantizeInt8(const float* values, size_t size, int8_t* out) {
+        float maxAbs = 0.0f;
+        for (size_t i = 0; i < size; ++i) {
+            maxAbs = std::max(maxAbs, std::fabs(values[i]));
+        }
+
+        if (maxAbs == 0.0f) {
+            std::fill(out, out + size, static_cast<int8_t>(0));
+            return 0.0f;
+        }
+
+        // -128 is never produced, which keeps the integer kernels free of saturation
+        const float scale = maxAbs / 127.0f;
+        const float inverse = 127.0f / maxAbs;
+        for (size_t i = 0; i < size; ++i) {
+            float q = std::nearbyint(values[i] * inverse);
+            out[i] = static_cast<int8_t>(std::clamp(q, -127.0f, 127.0f));
+        }
+        return scale;
+    }
+
+    Int8Matrix Int8Matrix::quantize(const MatrixView& m) {
+        Int8Matrix result;
+        result.data_.reserve(m.rows * m.cols);
+        result.scales_.reserve(m.rows);
+        for (size_t i = 0; i < m.rows; ++i) {
+            result.appendRow(m.row(i), m.cols);
+        }
+        return result;
+    }
+
+    void Int8Matrix::appendRow(const float* values, size_t size) {
+        if (rows_ == 0 && data_.empty()) {
+            cols_ = size;
+        } else if (size != cols_) {
+            throw std::runtime_error("Row length does not match matrix columns");
+        }
+
+        data_.resize(data_.size() + size);
+        scales_.push_back(quantizeInt8(values, size, data_.data() + rows_ * cols_));
+        ++rows_;
+    }
+
+    void Int8Matrix::dequantizeRow(size_t i, float* out) const {
+        const int8_t* values = row(i);
+        const float rowScale = scales_[i];
+        for (size_t j = 0; j < cols_; ++j) {
+            out[j] = static_cast<float>(values[j]) * rowScale;
+        }
+    }
+
+    Fp16Matrix Fp16Matrix::convert(const MatrixView& m) {
+        Fp16Matrix result;
+        result.data_.reserve(m.rows * m.cols);
+        for (size_t i = 0; i < m.rows; ++i) {
+            result.appendRow(m.row(i), m.cols);
+        }
+        return result;
+    }
+
+    void Fp16Matrix::appendRow(const float* values, size_t size) {
+        if (rows_ == 0 && data_.empty()) {
+            cols_ = size;
+        } else if (size != cols_) {
+            throw std::runtime_error("Row length does not match matrix columns");
+        }
+
+        for (size_t j = 0; j < size; ++j) {
+            data_.push_back(floatToHalf(values[j]));
+        }
+        ++rows_;
+    }
+
+    void Fp16Matrix::dequantizeRow(size_t i, float* out) const {
+        const uint16_t* values = row(i);
+        for (size_t j = 0; j < cols_; ++j) {
+            out[j] = halfToFloat(values[j]);
+        }
+    }
+
+    BinaryMatrix::BinaryMatrix(const MatrixView& rotation)
+        : rows_(0), cols_(0), words_(0) {
+        if (!rotation.empty()) {
+            if (rotation.rows != rotation.cols) {
+                throw std::runtime_error("Binary rotation must be a square matrix");
+            }
+            rotationColumns_ = transpose(rotation);
+        }
+    }
+
+    BinaryMatrix BinaryMatrix::encode(const MatrixView& m, const MatrixView& rotation) {
+        BinaryMatrix result(rotation);
+        if (m.empty()) {
+            return result;
+        }
+        if (!rotation.empty() && rotation.rows != m.cols) {
+            throw std::runtime_error("Binary rotation does not match embedding dimension");
+        }
+
+        result.cols_ = m.cols;
+        result.words_ = (m.cols + 63) / 64;
+        result.rows_ = m.rows;
+        result.data_.assign(m.rows * result.words_, 0);
+
+        if (rotation.empty()) {
+            for (size_t i = 0; i < m.rows; ++i) {
+                result.packSigns(m.row(i), result.data_.data() + i * result.words_);
+            }
+        } else {
+            // x * R for all rows as one GEMM
+            Matrix rotated;
+            matmulTransposed(m, result.rotationColumns_, rotated);
+            for (size_t i = 0; i < m.rows; ++i) {
+                result.packSigns(rotated.row(i), result.data_.data() + i * result.words_);
+            }
+        }
+
+        return result;
+    }
+
+    void BinaryMatrix::packSigns(const float* values, uint64_t* out) const {
+        std::fill(out, out + words_, 0);
+        for (size_t j = 0; j < cols_; ++j) {
+            if (values[j] > 0.0f) {
+                out[j / 64] |= uint64_t(1) << (j % 64);
+            }
+        }
+    }
+
+    void BinaryMatrix::encodeQuery(const float* values, size_t size, uint64_t* out) const {
+        if (size != cols_) {
+            throw std::runtime_error("Query length does not match binary code length");
+        }
+
+        if (rotationColumns_.empty()) {
+            packSigns(values, out);
+            return;
+        }
+
+        thread_local std::vector<float> rotated;
+        rotated.resize(cols_);
+        for (size_t j = 0; j < cols_; ++j) {
+            rotated[j] = dotProduct(values, rotationColumns_.row(j), cols_);
+        }
+        packSigns(rotated.data(), out);
+    }
+
+    void BinaryMatrix::appendRow(const float* values, size_t size) {
+        if (rows_ == 0 && data_.empty()) {
+            if (!rotationColumns_.empty() && rotationColumns_.rows() != size) {
+                throw std::runtime_error("Binary rotation does not match embedding dimension");
+            }
+            cols_ = size;
+            words_ = (size + 63) / 64;
+        }
+
+        data_.resize(data_.size() + words_);
+        encodeQuery(values, size, data_.data() + rows_ * words_);
+        ++rows_;
+    }
+
+    Matrix learnBinaryRotation(const MatrixView& samples, size_t iterations, uint32_t seed) {
+        const size_t d = samples.cols;
+        if (samples.rows < d) {
+            throw std::runtime_error("Binary rotation needs at least as many samples as dimensions");
+        }
+
+        Matrix v = Matrix::fromView(samples);
+        normalizeRows(v);
+        const Matrix vt = transpose(v);
+
+        // Random orthogonal start
+        std::mt19937 rng(seed);
+        std::normal_distribution<float> gauss(0.0f, 1.0f);
+        Matrix r(d, d);
+        for (size_t i = 0; i < d * d; ++i) {
+            r.data()[i] = gauss(rng);
+        }
+        r = orthogonalPolarFactor(r);
+
+        Matrix projected;
+        Matrix m;
+        Matrix bt(d, v.rows());
+        for (size_t iteration = 0; iteration < iterations; ++iteration) {
+            // B = sign(V * R), kept transposed for the next product
+            matmulTransposed(v, transpose(r), projected);
+            for (size_t i = 0; i < v.rows(); ++i) {
+                for (size_t j = 0; j < d; ++j) {
+                    bt(j, i) = projected(i, j) > 0.0f ? 1.0f : -1.0f;
+                }
+            }
+
+            // R = polar(V^T * B)
+            matmulTransposed(vt, bt, m);
+            r = orthogonalPolarFactor(m);
+        }
+
+        return r;
+    }
+
+    TopK topKBinaryRerank(const MatrixView& queries, const BinaryMatrix& codes, const MatrixView& corpus, size_t k, size_t candidates) {
+        if (corpus.rows != codes.rows() || (corpus.cols != codes.cols() && !codes.empty())) {
+            throw std::runtime_error("Binary codes do not match corpus");
+        }
+        if (queries.cols != corpus.cols && !queries.empty() && !corpus.empty()) {
+            throw std::runtime_error("Query and corpus dimensions must match");
+        }
+
+        TopK result;
+        result.rows = queries.rows;
+        result.k = std::min(k, corpus.rows);
+        result.entries.resize(result.rows * result.k, { 0, 0.0f });
+        if (result.k == 0) {
+            return result;
+        }
+
+        candidates = std::min(std::max(candidates, result.k), corpus.rows);
+        std::vector<uint64_t> queryCode(codes.words());
+        std::vector<uint32_t> distances(codes.rows());
+        std::vector<uint32_t> histogram(codes.cols() + 2);
+        std::vector<ScoredIndex> shortlist;
+        shortlist.reserve(candidates);
+
+        for (size_t i = 0; i < queries.rows; ++i) {
+            const float* query = queries.row(i);
+            codes.encodeQuery(query, queries.cols, queryCode.data());
+            hammingDistances(queryCode.data(), codes.row(0), codes.rows(), codes.words(), distances.data());
+
+            // Distances are small integers: a histogram finds the cut-off in O(N) without sorting
+            std::fill(histogram.begin(), histogram.end(), 0);
+            for (uint32_t distance : distances) {
+                ++histogram[distance];
+            }
+            uint32_t threshold = 0;
+            size_t below = 0;
+            while (below + histogram[threshold] < candidates) {
+                below += histogram[threshold++];
+            }
+            size_t atThreshold = candidates - below;
+
+            shortlist.clear();
+            for (size_t j = 0; j < distances.size(); ++j) {
+                if (distances[j] < threshold || (distances[j] == threshold && atThreshold > 0 && atThreshold--)) {
+                    shortlist.push_back({ static_cast<uint32_t>(j), 0.0f });
+                }
+            }
+
+            // Exact cosine on the shortlist
+            const float queryNorm = std::sqrt(squaredL2Norm(query, queries.cols));
+            for (auto& candidate : shortlist) {
+                const float* row = corpus.row(candidate.index);
+                const float norms = queryNorm * std::sqrt(squaredL2Norm(row, corpus.cols));
+                candidate.score = norms > 0.0f ? dotProduct(query, row, corpus.cols) / norms : 0.0f;
+            }
+            std::partial_sort(shortlist.begin(), shortlist.begin() + result.k, shortlist.end(), betterMatch);
+            std::copy(shortlist.begin(), shortlist.begin() + result.k, result.entries.begin() + i * result.k);
+        }
+
+        return result;
+    }
+
+    TopK topKDotProduct(const MatrixView& queries, const Int8Matrix& corpus, size_t k) {
+        if (queries.cols != corpus.cols() && !queries.empty() && !corpus.empty()) {
+            throw std::runtime_error("Query and corpus dimensions must match");
+        }
+
+        std::vector<int8_t> query(queries.cols);
+        return scanTopK(queries.rows, corpus.rows(), k, [&](size_t i, auto&& push) {
+            const float queryScale = quantizeInt8(queries.row(i), queries.cols, query.data());
+            for (size_t j = 0; j < corpus.rows(); ++j) {
+                int32_t dot = dotProductInt8(query.data(), corpus.row(j), queries.cols);
+                push(static_cast<uint32_t>(j), static_cast<float>(dot) * queryScale * corpus.scale(j));
+            }
+        });
+    }
+
+    TopK topKDotProduct(const MatrixView& queries, const Fp16Matrix& corpus, size_t k) {
+        if (queries.cols != corpus.cols() && !queries.empty() && !corpus.empty()) {
+            throw std::runtime_error("Query and corpus dimensions must match");
+        }
+
+        return scanTopK(queries.rows, corpus.rows(), k, [&](size_t i, auto&& push) {
+            const float* query = queries.row(i);
+            for (size_t j = 0; j < corpus.rows(); ++j) {
+                push(static_cast<uint32_t>(j), dotProductFp16(query, corpus.row(j), queries.cols));
+            }
+        });
+    }
+
+} // namespace math
@@ -0,0 +1,657 @@
+#include "../include/math/SimdKernels.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MATH_SIMD_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// MSVC compiles any intrinsic without flags; GCC/Clang need per-function target attributes
+#if defined(MATH_SIMD_X86) && !defined(_MSC_VER)
+#define MATH_TARGET_SSE2 __attribute__((target("sse2")))
+#define MATH_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define MATH_TARGET_AVX512 __attribute__((target("avx512f")))
+#define MATH_TARGET_F16C __attribute__((target("avx2,fma,f16c")))
+#define MATH_TARGET_VNNI __attribute__((target("avx512f,avx512bw,avx512vnni")))
+#define MATH_TARGET_POPCNT __attribute__((target("popcnt")))
+#define MATH_TARGET_VPOPCNTDQ __attribute__((target("avx512f,avx512vpopcntdq")))
+#else
+#define MATH_TARGET_SSE2
+#define MATH_TARGET_AVX2
+#define MATH_TARGET_AVX512
+#define MATH_TARGET_F16C
+#define MATH_TARGET_VNNI
+#define MATH_TARGET_POPCNT
+#define MATH_TARGET_VPOPCNTDQ
+#endif
+
+namespace math {
+
+    float halfToFloat(uint16_t half) {
+        const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+        uint32_t exponent = (half >> 10) & 0x1F;
+        uint32_t mantissa = half & 0x3FF;
+        uint32_t bits;
+
+        if (exponent == 0) {
+            if (mantissa == 0) {
+                bits = sign;
+            } else {
+                // Subnormal half is a normal float: shift the leading one into place
+                exponent = 127 - 15 + 1;
+                while ((mantissa & 0x400) == 0) {
+                    mantissa <<= 1;
+                    --exponent;
+                }
+                bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+            }
+        } else if (exponent == 31) {
+            bits = sign | 0x7F800000 | (mantissa << 13);
+        } else {
+            bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+        }
+
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    namespace {
+
+        // Scalar kernels, also the reference for the SIMD versions
+
+        float dotScalar(const float* a, const float* b, size_t n) {
+            float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                s0 += a[i] * b[i];
+                s1 += a[i + 1] * b[i + 1];
+                s2 += a[i + 2] * b[i + 2];
+                s3 += a[i + 3] * b[i + 3];
+            }
+            for (; i < n; ++i) {
+                s0 += a[i] * b[i];
+            }
+            return (s0 + s1) + (s2 + s3);
+        }
+
+        float squaredNormScalar(const float* a, size_t n) {
+            return dotScalar(a, a, n);
+        }
+
+        void gemm4x16Scalar(const float* const* aRows, const float* strip, size_t kc, float* acc) {
+            for (size_t k = 0; k < kc; ++k) {
+                const float* bk = strip + k * 16;
+                for (size_t r = 0; r < 4; ++r) {
+                    const float ar = aRows[r][k];
+                    for (size_t j = 0; j < 16; ++j) {
+                        acc[r * 16 + j] += ar * bk[j];
+                    }
+                }
+            }
+        }
+
+        int32_t dotInt8Scalar(const int8_t* a, const int8_t* b, size_t n) {
+            int32_t sum = 0;
+            for (size_t i = 0; i < n; ++i) {
+                sum += static_cast<int32_t>(a[i]) * static_cast<int32_t>(b[i]);
+            }
+            return sum;
+        }
+
+        float dotFp16Scalar(const float* a, const uint16_t* b, size_t n) {
+            float s0 = 0.0f, s1 = 0.0f;
+            size_t i = 0;
+            for (; i + 2 <= n; i += 2) {
+                s0 += a[i] * halfToFloat(b[i]);
+                s1 += a[i + 1] * halfToFloat(b[i + 1]);
+            }
+            for (; i < n; ++i) {
+                s0 += a[i] * halfToFloat(b[i]);
+            }
+            return s0 + s1;
+        }
+
+        uint32_t popcountScalar(uint64_t x) {
+            x = x - ((x >> 1) & 0x5555555555555555ULL);
+            x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+            x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+            return static_cast<uint32_t>((x * 0x0101010101010101ULL) >> 56);
+        }
+
+        void hammingScalar(const uint64_t* query, const uint64_t* codes, size_t rows, size_t words, uint32_t* distances) {
+            for (size_t r = 0; r < rows; ++r) {
+                const uint64_t* code = codes + r * words;
+                uint32_t distance = 0;
+                for (size_t w = 0; w < words; ++w) {
+                    distance += popcountScalar(query[w] ^ code[w]);
+                }
+                distances[r] = distance;
+            }
+        }
+
+        void pqScanScalar(const float* lut, const uint8_t* codes, size_t blocks, size_t subspaces, float* scores) {
+            for (size_t b = 0; b < blocks; ++b) {
+                const uint8_t* block = codes + b * subspaces * 16;
+                float* out = scores + b * 16;
+                std::fill(out, out + 16, 0.0f);
+                for (size_t s = 0; s < subspaces; ++s) {
+                    const float* table = lut + s * 256;
+                    for (size_t j = 0; j < 16; ++j) {
+                        out[j] += table[block[s * 16 + j]];
+                    }
+                }
+            }
+        }
+
+#ifdef MATH_SIMD_X86
+
+        MATH_TARGET_SSE2 float horizontalSum(__m128 v) {
+            __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+            __m128 sums = _mm_add_ps(v, shuf);
+            shuf = _mm_movehl_ps(shuf, sums);
+            sums = _mm_add_ss(sums, shuf);
+            return _mm_cvtss_f32(sums);
+        }
+
+        MATH_TARGET_SSE2 float dotSSE2(const float* a, const float* b, size_t n) {
+            __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps(), s2 = _mm_setzero_ps(), s3 = _mm_setzero_ps();
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+                s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+                s2 = _mm_add_ps(s2, _mm_mul_ps(_mm_loadu_ps(a + i + 8), _mm_loadu_ps(b + i + 8)));
+                s3 = _mm_add_ps(s3, _mm_mul_ps(_mm_loadu_ps(a + i + 12), _mm_loadu_ps(b + i + 12)));
+            }
+            for (; i + 4 <= n; i += 4) {
+                s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+            }
+            float sum = horizontalSum(_mm_add_ps(_mm_add_ps(s0, s1), _mm_add_ps(s2, s3)));
+            for (; i < n; ++i) {
+                sum += a[i] * b[i];
+            }
+            return sum;
+        }
+
+        MATH_TARGET_SSE2 float squaredNormSSE2(const float* a, size_t n) {
+            return dotSSE2(a, a, n);
+        }
+
+        MATH_TARGET_AVX2 float horizontalSum256(__m256 v) {
+            __m128 lo = _mm256_castps256_ps128(v);
+            __m128 hi = _mm256_extractf128_ps(v, 1);
+            lo = _mm_add_ps(lo, hi);
+            __m128 shuf = _mm_movehdup_ps(lo);
+            __m128 sums = _mm_add_ps(lo, shuf);
+            shuf = _mm_movehl_ps(shuf, sums);
+            sums = _mm_add_ss(sums, shuf);
+            return _mm_cvtss_f32(sums);
+        }
+
+        MATH_TARGET_AVX2 float dotAVX2(const float* a, const float* b, size_t n) {
+            __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps(), s2 = _mm256_setzero_ps(), s3 = _mm256_setzero_ps();
+            size_t i = 0;
+            for (; i + 32 <= n; i += 32) {
+                s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), s0);
+                s1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), s1);
+                s2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), s2);
+                s3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), s3);
+            }
+            for (; i + 8 <= n; i += 8) {
+                s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), s0);
+            }
+            float sum = horizontalSum256(_mm256_add_ps(_mm256_add_ps(s0, s1), _mm256_add_ps(s2, s3)));
+            for (; i < n; ++i) {
+                sum += a[i] * b[i];
+            }
+            return sum;
+        }
+
+        MATH_TARGET_AVX2 float squaredNormAVX2(const float* a, size_t n) {
+            return dotAVX2(a, a, n);
+        }
+
+        // 4 rows x 16 columns = 8 ymm accumulators, one broadcast per row and k
+        MATH_TARGET_AVX2 void gemm4x16AVX2(const float* const* aRows, const float* strip, size_t kc, float* acc) {
+            __m256 c00 = _mm256_loadu_ps(acc), c01 = _mm256_loadu_ps(acc + 8);
+            __m256 c10 = _mm256_loadu_ps(acc + 16), c11 = _mm256_loadu_ps(acc + 24);
+            __m256 c20 = _mm256_loadu_ps(acc + 32), c21 = _mm256_loadu_ps(acc + 40);
+            __m256 c30 = _mm256_loadu_ps(acc + 48), c31 = _mm256_loadu_ps(acc + 56);
+            const float* a0 = aRows[0];
+            const float* a1 = aRows[1];
+            const float* a2 = aRows[2];
+            const float* a3 = aRows[3];
+
+            for (size_t k = 0; k < kc; ++k) {
+                __m256 b0 = _mm256_loadu_ps(strip + k * 16);
+                __m256 b1 = _mm256_loadu_ps(strip + k * 16 + 8);
+                __m256 a = _mm256_broadcast_ss(a0 + k);
+                c00 = _mm256_fmadd_ps(a, b0, c00);
+                c01 = _mm256_fmadd_ps(a, b1, c01);
+                a = _mm256_broadcast_ss(a1 + k);
+                c10 = _mm256_fmadd_ps(a, b0, c10);
+                c11 = _mm256_fmadd_ps(a, b1, c11);
+                a = _mm256_broadcast_ss(a2 + k);
+                c20 = _mm256_fmadd_ps(a, b0, c20);
+                c21 = _mm256_fmadd_ps(a, b1, c21);
+                a = _mm256_broadcast_ss(a3 + k);
+                c30 = _mm256_fmadd_ps(a, b0, c30);
+                c31 = _mm256_fmadd_ps(a, b1, c31);
+            }
+
+            _mm256_storeu_ps(acc, c00);
+            _mm256_storeu_ps(acc + 8, c01);
+            _mm256_storeu_ps(acc + 16, c10);
+            _mm256_storeu_ps(acc + 24, c11);
+            _mm256_storeu_ps(acc + 32, c20);
+            _mm256_storeu_ps(acc + 40, c21);
+            _mm256_storeu_ps(acc + 48, c30);
+            _mm256_storeu_ps(acc + 56, c31);
+        }
+
+        // |a| * sign(b, a) keeps the products exact for unsigned x signed maddubs; inputs stay in [-127, 127],
+        // so a pair of products (at most 2 * 127 * 127) never saturates int16
+        MATH_TARGET_AVX2 int32_t dotInt8AVX2(const int8_t* a, const int8_t* b, size_t n) {
+            const __m256i ones = _mm256_set1_epi16(1);
+            __m256i acc = _mm256_setzero_si256();
+            size_t i = 0;
+            for (; i + 32 <= n; i += 32) {
+                __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+                __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+                __m256i pairs = _mm256_maddubs_epi16(_mm256_abs_epi8(va), _mm256_sign_epi8(vb, va));
+                acc = _mm256_add_epi32(acc, _mm256_madd_epi16(pairs, ones));
+            }
+            __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+            sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+            sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+            int32_t result = _mm_cvtsi128_si32(sum);
+            for (; i < n; ++i) {
+                result += static_cast<int32_t>(a[i]) * static_cast<int32_t>(b[i]);
+            }
+            return result;
+        }
+
+        MATH_TARGET_F16C float dotFp16F16C(const float* a, const uint16_t* b, size_t n) {
+            __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                __m256 b0 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+                __m256 b1 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i + 8)));
+                s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), b0, s0);
+                s1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), b1, s1);
+            }
+            float sum = horizontalSum256(_mm256_add_ps(s0, s1));
+            for (; i < n; ++i) {
+                sum += a[i] * halfToFloat(b[i]);
+            }
+            return sum;
+        }
+
+        // 16 codes of one subspace widen to two 8-lane index vectors for table gathers
+        MATH_TARGET_AVX2 void pqScanAVX2(const float* lut, const uint8_t* codes, size_t blocks, size_t subspaces, float* scores) {
+            for (size_t b = 0; b < blocks; ++b) {
+                const uint8_t* block = codes + b * subspaces * 16;
+                __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+                for (size_t s = 0; s < subspaces; ++s) {
+                    const float* table = lut + s * 256;
+                    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + s * 16));
+                    __m256i idx0 = _mm256_cvtepu8_epi32(bytes);
+                    __m256i idx1 = _mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8));
+                    acc0 = _mm256_add_ps(acc0, _mm256_i32gather_ps(table, idx0, 4));
+                    acc1 = _mm256_add_ps(acc1, _mm256_i32gather_ps(table, idx1, 4));
+                }
+                _mm256_storeu_ps(scores + b * 16, acc0);
+                _mm256_storeu_ps(scores + b * 16 + 8, acc1);
+            }
+        }
+
+        MATH_TARGET_AVX512 void pqScanAVX512(const float* lut, const uint8_t* codes, size_t blocks, size_t subspaces, float* scores) {
+            for (size_t b = 0; b < blocks; ++b) {
+                const uint8_t* block = codes + b * subspaces * 16;
+                __m512 acc = _mm512_setzero_ps();
+                for (size_t s = 0; s < subspaces; ++s) {
+                    // Full-mask forms of the zero-extend and gather, same code without GCC's uninitialized-source warning
+                    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + s * 16));
+                    __m512i idx = _mm512_maskz_cvtepu8_epi32(0xFFFF, bytes);
+                    acc = _mm512_add_ps(acc, _mm512_mask_i32gather_ps(_mm512_setzero_ps(), 0xFFFF, idx, lut + s * 256, 4));
+                }
+                _mm512_storeu_ps(scores + b * 16, acc);
+            }
+        }
+
+        MATH_TARGET_AVX512 float dotAVX512(const float* a, const float* b, size_t n) {
+            __m512 s0 = _mm512_setzero_ps(), s1 = _mm512_setzero_ps(), s2 = _mm512_setzero_ps(), s3 = _mm512_setzero_ps();
+            size_t i = 0;
+            for (; i + 64 <= n; i += 64) {
+                s0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), s0);
+                s1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), s1);
+                s2 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 32), _mm512_loadu_ps(b + i + 32), s2);
+                s3 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 48), _mm512_loadu_ps(b + i + 48), s3);
+            }
+            for (; i + 16 <= n; i += 16) {
+                s0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), s0);
+            }
+            if (i < n) {
+                // Masked tail, lanes past n load as zero
+                __mmask16 mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+                s1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i), s1);
+            }
+            alignas(64) float lanes[16];
+            _mm512_store_ps(lanes, _mm512_add_ps(_mm512_add_ps(s0, s1), _mm512_add_ps(s2, s3)));
+            float sum = 0.0f;
+            for (float lane : lanes) {
+                sum += lane;
+            }
+            return sum;
+        }
+
+        MATH_TARGET_AVX512 float squaredNormAVX512(const float* a, size_t n) {
+            return dotAVX512(a, a, n);
+        }
+
+        // AVX-512F converts half precision natively, no F16C needed
+        MATH_TARGET_AVX512 float dotFp16AVX512(const float* a, const uint16_t* b, size_t n) {
+            __m512 s0 = _mm512_setzero_ps(), s1 = _mm512_setzero_ps();
+            size_t i = 0;
+            for (; i + 32 <= n; i += 32) {
+                // Full-mask conversions avoid GCC's uninitialized-source warning
+                __m512 b0 = _mm512_maskz_cvtph_ps(0xFFFF, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+                __m512 b1 = _mm512_maskz_cvtph_ps(0xFFFF, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i + 16)));
+                s0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), b0, s0);
+                s1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), b1, s1);
+            }
+            alignas(64) float lanes[16];
+            _mm512_store_ps(lanes, _mm512_add_ps(s0, s1));
+            float sum = 0.0f;
+            for (float lane : lanes) {
+                sum += lane;
+            }
+            for (; i < n; ++i) {
+                sum += a[i] * halfToFloat(b[i]);
+            }
+            return sum;
+        }
+
+        // VPDPBUSD multiplies unsigned by signed bytes and adds groups of four straight into int32 lanes
+        // Signed x signed goes through |a| and b negated where a < 0
+        MATH_TARGET_VNNI int32_t dotInt8VNNI(const int8_t* a, const int8_t* b, size_t n) {
+            const __m512i zero = _mm512_setzero_si512();
+            __m512i acc = _mm512_setzero_si512();
+            size_t i = 0;
+            for (; i < n; i += 64) {
+                // Masked tail, bytes past n load as zero
+                const __mmask64 mask = n - i >= 64 ? ~0ULL : (1ULL << (n - i)) - 1;
+                __m512i va = _mm512_maskz_loadu_epi8(mask, a + i);
+                __m512i vb = _mm512_maskz_loadu_epi8(mask, b + i);
+                __m512i signedB = _mm512_mask_sub_epi8(vb, _mm512_movepi8_mask(va), zero, vb);
+                acc = _mm512_dpbusd_epi32(acc, _mm512_abs_epi8(va), signedB);
+            }
+            alignas(64) int32_t lanes[16];
+            _mm512_store_si512(lanes, acc);
+            int32_t sum = 0;
+            for (int32_t lane : lanes) {
+                sum += lane;
+            }
+            return sum;
+        }
+
+        MATH_TARGET_POPCNT void hammingPopcnt(const uint64_t* query, const uint64_t* codes, size_t rows, size_t words, uint32_t* distances) {
+            for (size_t r = 0; r < rows; ++r) {
+                const uint64_t* code = codes + r * words;
+                uint64_t distance = 0;
+                for (size_t w = 0; w < words; ++w) {
+                    const uint64_t diff = query[w] ^ code[w];
+#if defined(_M_X64) || defined(__x86_64__)
+                    distance += static_cast<uint64_t>(_mm_popcnt_u64(diff));
+#else
+                    distance += static_cast<uint64_t>(_mm_popcnt_u32(static_cast<uint32_t>(diff)) + _mm_popcnt_u32(static_cast<uint32_t>(diff >> 32)));
+#endif
+                }
+                distances[r] = static_cast<uint32_t>(distance);
+            }
+        }
+
+        // 512 bits per instruction; the per-row lane sum is the only horizontal step
+        MATH_TARGET_VPOPCNTDQ void hammingVpopcntdq(const uint64_t* query, const uint64_t* codes, size_t rows, size_t words, uint32_t* distances) {
+            for (size_t r = 0; r < rows; ++r) {
+                const uint64_t* code = codes + r * words;
+                __m512i counts = _mm512_setzero_si512();
+                for (size_t w = 0; w < words; w += 8) {
+                    // Masked tail, words past the end load as zero on both sides
+                    const __mmask8 mask = words - w >= 8 ? 0xFF : static_cast<__mmask8>((1u << (words - w)) - 1);
+                    __m512i diff = _mm512_xor_si512(_mm512_maskz_loadu_epi64(mask, query + w), _mm512_maskz_loadu_epi64(mask, code + w));
+                    counts = _mm512_add_epi64(counts, _mm512_popcnt_epi64(diff));
+                }
+                alignas(64) uint64_t lanes[8];
+                _mm512_store_si512(lanes, counts);
+                uint64_t distance = 0;
+                for (uint64_t lane : lanes) {
+                    distance += lane;
+                }
+                distances[r] = static_cast<uint32_t>(distance);
+            }
+        }
+
+        // Extensions that only some kernels use, on top of the base level
+        struct X86Features {
+            SimdLevel level = SimdLevel::Scalar;
+            bool f16c = false;
+            bool avx512bw = false;
+            bool avx512vnni = false;
+            bool popcnt = false;
+            bool avx512vpopcntdq = false;
+        };
+
+        // Check CPUID feature bits and that the OS saves the wider registers (XCR0)
+        X86Features detectX86() {
+            X86Features features;
+            int info[4] = { 0, 0, 0, 0 };
+            auto cpuid = [&info](int leaf, int subleaf) {
+#ifdef _MSC_VER
+                __cpuidex(info, leaf, subleaf);
+#else
+                unsigned int r[4] = { 0, 0, 0, 0 };
+                __cpuid_count(leaf, subleaf, r[0], r[1], r[2], r[3]);
+                for (int i = 0; i < 4; ++i) {
+                    info[i] = static_cast<int>(r[i]);
+                }
+#endif
+            };
+
+            cpuid(0, 0);
+            const int maxLeaf = info[0];
+            cpuid(1, 0);
+            const bool sse2 = (info[3] & (1 << 26)) != 0;
+            const bool osxsave = (info[2] & (1 << 27)) != 0;
+            const bool avx = (info[2] & (1 << 28)) != 0;
+            const bool fma = (info[2] & (1 << 12)) != 0;
+            const bool f16c = (info[2] & (1 << 29)) != 0;
+            features.popcnt = (info[2] & (1 << 23)) != 0;
+
+            unsigned long long xcr0 = 0;
+            if (osxsave) {
+#ifdef _MSC_VER
+                xcr0 = _xgetbv(0);
+#else
+                unsigned int lo = 0, hi = 0;
+                __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+                xcr0 = (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+            }
+            const bool ymmState = (xcr0 & 0x6) == 0x6;
+            const bool zmmState = (xcr0 & 0xE6) == 0xE6;
+
+            bool avx2 = false;
+            bool avx512f = false;
+            if (maxLeaf >= 7) {
+                cpuid(7, 0);
+                avx2 = (info[1] & (1 << 5)) != 0;
+                avx512f = (info[1] & (1 << 16)) != 0;
+                features.avx512bw = avx512f && zmmState && (info[1] & (1 << 30)) != 0;
+                features.avx512vnni = features.avx512bw && (info[2] & (1 << 11)) != 0;
+                features.avx512vpopcntdq = avx512f && zmmState && (info[2] & (1 << 14)) != 0;
+            }
+            features.f16c = f16c && ymmState;
+
+            if (avx512f && zmmState) {
+                features.level = SimdLevel::AVX512;
+            } else if (avx && avx2 && fma && ymmState) {
+                features.level = SimdLevel::AVX2;
+            } else {
+                features.level = sse2 ? SimdLevel::SSE2 : SimdLevel::Scalar;
+            }
+            return features;
+        }
+
+        const X86Features& x86Features() {
+            static const X86Features features = detectX86();
+            return features;
+        }
+
+
+#endif // MATH_SIMD_X86
+
+        struct KernelTable {
+            SimdLevel level;
+            float (*dot)(const float*, const float*, size_t);
+            float (*squaredNorm)(const float*, size_t);
+            void (*gemm4x16)(const float* const*, const float*, size_t, float*);
+            void (*pqScan)(const float*, const uint8_t*, size_t, size_t, float*);
+            int32_t (*dotInt8)(const int8_t*, const int8_t*, size_t);
+            float (*dotFp16)(const float*, const uint16_t*, size_t);
+            void (*hamming)(const uint64_t*, const uint64_t*, size_t, size_t, uint32_t*);
+        };
+
+        KernelTable makeTable(SimdLevel level) {
+            switch (level) {
+#ifdef MATH_SIMD_X86
+            case SimdLevel::AVX512:
+                // GEMM tile is already FMA-bound on ymm registers
+                return { level, dotAVX512, squaredNormAVX512, gemm4x16AVX2, pqScanAVX512,
+                         x86Features().avx512vnni ? dotInt8VNNI : dotInt8AVX2, dotFp16AVX512,
+                         x86Features().avx512vpopcntdq ? hammingVpopcntdq : hammingPopcnt };
+            case SimdLevel::AVX2:
+                return { level, dotAVX2, squaredNormAVX2, gemm4x16AVX2, pqScanAVX2,
+                         dotInt8AVX2, x86Features().f16c ? dotFp16F16C : dotFp16Scalar,
+                         x86Features().popcnt ? hammingPopcnt : hammingScalar };
+            case SimdLevel::SSE2:
+                // No gather before AVX2
+                return { level, dotSSE2, squaredNormSSE2, gemm4x16Scalar, pqScanScalar, dotInt8Scalar, dotFp16Scalar,
+                         x86Features().popcnt ? hammingPopcnt : hammingScalar };
+#endif
+            default:
+                return { SimdLevel::Scalar, dotScalar, squaredNormScalar, gemm4x16Scalar, pqScanScalar, dotInt8Scalar, dotFp16Scalar,
+                         hammingScalar };
+            }
+        }
+
+        KernelTable& kernels() {
+            static KernelTable table = makeTable(detectSimdLevel());
+            return table;
+        }
+
+    } // namespace
+
+    SimdLevel detectSimdLevel() {
+#ifdef MATH_SIMD_X86
+        return x86Features().level;
+#else
+        return SimdLevel::Scalar;
+#endif
+    }
+
+    SimdLevel activeSimdLevel() {
+        return kernels().level;
+    }
+
+    void setSimdLevel(SimdLevel level) {
+        if (static_cast<int>(level) > static_cast<int>(detectSimdLevel())) {
+            level = detectSimdLevel();
+        }
+        kernels() = makeTable(level);
+    }
+
+    const char* simdLevelName(SimdLevel level) {
+        switch (level) {
+        case SimdLevel::AVX512: return "avx512";
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::SSE2: return "sse2";
+        default: return "scalar";
+        }
+    }
+
+    float dotProduct(const float* a, const float* b, size_t n) {
+        return kernels().dot(a, b, n);
+    }
+
+    float squaredL2Norm(const float* a, size_t n) {
+        return kernels().squaredNorm(a, n);
+    }
+
+    void gemmKernel4x16(const float* const* aRows, const float* strip, size_t kc, float* acc) {
+        kernels().gemm4x16(aRows, strip, kc, acc);
+    }
+
+    void pqScanBlocks(const float* lut, const uint8_t* codes, size_t blocks, size_t subspaces, float* scores) {
+        kernels().pqScan(lut, codes, blocks, subspaces, scores);
+    }
+
+    void hammingDistances(const uint64_t* query, const uint64_t* codes, size_t rows, size_t words, uint32_t* distances) {
+        kernels().hamming(query, codes, rows, words, distances);
+    }
+
+    int32_t dotProductInt8(const int8_t* a, const int8_t* b, size_t n) {
+        return kernels().dotInt8(a, b, n);
+    }
+
+    float dotProductFp16(const float* a, const uint16_t* b, size_t n) {
+        return kernels().dotFp16(a, b, n);
+    }
+
+    uint16_t floatToHalf(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+        const int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+        uint32_t mantissa = bits & 0x7FFFFF;
+
+        if ((bits & 0x7F800000) == 0x7F800000) {
+            // Inf stays inf, NaN stays quiet NaN
+            return static_cast<uint16_t>(sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0));
+        }
+        if (exponent >= 31) {
+            return static_cast<uint16_t>(sign | 0x7C00);
+        }
+
+        if (exponent <= 0) {
+            // Subnormal half or zero
+            if (exponent < -10) {
+                return sign;
+            }
+            mantissa |= 0x800000;
+            const uint32_t shift = static_cast<uint32_t>(14 - exponent);
+            uint32_t half = mantissa >> shift;
+            const uint32_t remainder = mantissa & ((1u << shift) - 1);
+            const uint32_t halfway = 1u << (shift - 1);
+            if (remainder > halfway || (remainder == halfway && (half & 1))) {
+                ++half;
+            }
+            return static_cast<uint16_t>(sign | half);
+        }
+
+        // Round to nearest even; a carry out of the mantissa correctly bumps the exponent
+        uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+        const uint32_t remainder = mantissa & 0x1FFF;
+        if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) {
+            ++half;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+
+} // namespace math
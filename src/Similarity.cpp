@@ -1,17 +1,16 @@
 #include "../include/math/Similarity.h"
+#include "../include/math/SimdKernels.h"
+#include "../include/utils/ThreadPool.h"
 #include <cmath>
 #include <algorithm>
+#include <atomic>
 #include <numeric>
 #include <stdexcept>
 
 namespace math {
 
     float l2Norm(const std::vector<float>& vec) {
-        float sum = 0.0f;
-        for (float v : vec) {
-            sum += v * v;
-        }
-        return std::sqrt(sum);
+        return std::sqrt(squaredL2Norm(vec.data(), vec.size()));
     }
 
     float cosineSimilarity(const std::vector<float>& a, const std::vector<float>& b) {
@@ -20,10 +19,7 @@ namespace math {
         }
 
         // Dot product
-        float dotProduct = 0.0f;
-        for (size_t i = 0; i < a.size(); ++i) {
-            dotProduct += a[i] * b[i];
-        }
+        float dot = dotProduct(a.data(), b.data(), a.size());
 
         // Norms
         float normA = l2Norm(a);
@@ -33,7 +29,14 @@ namespace math {
             return 0.0f;
         }
 
-        return dotProduct / (normA * normB);
+        return dot / (normA * normB);
+    }
+
+    float cosineSimilarityNormalized(const std::vector<float>& a, const std::vector<float>& b) {
+        if (a.size() != b.size()) {
+            throw std::runtime_error("Vector sizes must match for cosine similarity");
+        }
+        return dotProduct(a.data(), b.data(), a.size());
     }
 
     std::vector<std::vector<float>> cosineSimilarityMatrix(
@@ -44,49 +47,330 @@ namespace math {
             return {};
         }
 
-        // Normalize all vectors
-        std::vector<std::vector<float>> aNorm(a.size());
-        std::vector<std::vector<float>> bNorm(b.size());
+        return cosineSimilarityMatrix(Matrix::fromRows(a), Matrix::fromRows(b)).toRows();
+    }
+
+    void normalize(float* vec, size_t size) {
+        float norm = std::sqrt(squaredL2Norm(vec, size));
+        if (norm > 0.0f) {
+            float inv = 1.0f / norm;
+            for (size_t k = 0; k < size; ++k) {
+                vec[k] *= inv;
+            }
+        }
+    }
+
+    void normalize(std::vector<float>& vec) {
+        normalize(vec.data(), vec.size());
+    }
+
+    void normalizeRows(Matrix& m) {
+        for (size_t i = 0; i < m.rows(); ++i) {
+            normalize(m.row(i), m.cols());
+        }
+    }
+
+    namespace {
 
-        for (size_t i = 0; i < a.size(); ++i) {
-            float norm = l2Norm(a[i]);
-            if (norm > 0.0f) {
-                aNorm[i].resize(a[i].size());
-                for (size_t j = 0; j < a[i].size(); ++j) {
-                    aNorm[i][j] = a[i][j] / norm;
+        // Register tile of the micro-kernel: MR rows of a times NR columns of c
+        constexpr size_t GEMM_MR = 4;
+        constexpr size_t GEMM_NR = 16;
+        static_assert(GEMM_MR == 4 && GEMM_NR == 16, "Register tile must match gemmKernel4x16");
+
+        // Cache blocks: packed b panel is KC x NC floats (128 KB), fits in L2
+        constexpr size_t GEMM_KC = 256;
+        constexpr size_t GEMM_NC = 128;
+
+        // Query rows scored per tile in top-K search: tile is TOPK_QUERY_BLOCK x GEMM_NC floats (32 KB)
+        constexpr size_t TOPK_QUERY_BLOCK = 64;
+
+        // Below this many multiply-adds a product runs on the calling thread only
+        constexpr size_t PARALLEL_MIN_WORK = size_t(1) << 22;
+
+        std::atomic<size_t> requestedThreads{0};
+
+        size_t ceilDiv(size_t a, size_t b) {
+            return (a + b - 1) / b;
+        }
+
+        // Split `units` work units into at most threadCount() contiguous shards
+        // Shard boundaries fall on whole units, so every output is computed exactly as on one thread
+        template <typename Shard>
+        void parallelShards(size_t units, size_t work, Shard&& shard) {
+            size_t shards = work < PARALLEL_MIN_WORK ? 1 : std::min(units, threadCount());
+            if (shards <= 1) {
+                shard(size_t(0), units);
+                return;
+            }
+
+            const size_t perShard = ceilDiv(units, shards);
+            shards = ceilDiv(units, perShard);
+            utils::defaultThreadPool().parallelFor(shards, [&](size_t s) {
+                shard(s * perShard, std::min(units, (s + 1) * perShard));
+            });
+        }
+
+        // Pack b[j0:j0+nc, k0:k0+kc] as NR-wide column strips: panel[strip][k][0..NR)
+        // Columns past the end of b are zero-padded so the kernel never branches
+        void packPanel(const MatrixView& b, size_t j0, size_t nc, size_t k0, size_t kc, float* panel) {
+            for (size_t js = 0; js < nc; js += GEMM_NR) {
+                float* strip = panel + js * kc;
+                for (size_t k = 0; k < kc; ++k) {
+                    for (size_t jj = 0; jj < GEMM_NR; ++jj) {
+                        size_t j = js + jj;
+                        strip[k * GEMM_NR + jj] = j < nc ? b(j0 + j, k0 + k) : 0.0f;
+                    }
                 }
+            }
+        }
+
+        // c[rows, 0:cols) += a[rows, k0:k0+kc] * strip, accumulating in a MR x NR register tile
+        template <size_t Rows>
+        void microKernel(const MatrixView& a, size_t i0, size_t k0, size_t kc, const float* strip, float* const* cRows, size_t cols) {
+            float acc[Rows][GEMM_NR] = {};
+            const float* aRows[Rows];
+            for (size_t r = 0; r < Rows; ++r) {
+                aRows[r] = a.row(i0 + r) + k0;
+            }
+
+            if constexpr (Rows == GEMM_MR) {
+                // Full tile goes to the dispatched SIMD kernel
+                gemmKernel4x16(aRows, strip, kc, &acc[0][0]);
             } else {
-                aNorm[i] = a[i];
+                for (size_t k = 0; k < kc; ++k) {
+                    const float* bk = strip + k * GEMM_NR;
+                    for (size_t r = 0; r < Rows; ++r) {
+                        const float ar = aRows[r][k];
+                        for (size_t jj = 0; jj < GEMM_NR; ++jj) {
+                            acc[r][jj] += ar * bk[jj];
+                        }
+                    }
+                }
             }
+
+            for (size_t r = 0; r < Rows; ++r) {
+                for (size_t jj = 0; jj < cols; ++jj) {
+                    cRows[r][jj] += acc[r][jj];
+                }
+            }
+        }
+
+        // Number of panel columns after padding nc to whole strips
+        size_t paddedColumns(size_t nc) {
+            return (nc + GEMM_NR - 1) / GEMM_NR * GEMM_NR;
         }
 
-        for (size_t i = 0; i < b.size(); ++i) {
-            float norm = l2Norm(b[i]);
-            if (norm > 0.0f) {
-                bNorm[i].resize(b[i].size());
-                for (size_t j = 0; j < b[i].size(); ++j) {
-                    bNorm[i][j] = b[i][j] / norm;
+        // c[0:rows, 0:nc) += a[i0:i0+rows, k0:k0+kc] * panel
+        // c points at the first output row, consecutive rows are ldc floats apart
+        void multiplyPanel(const MatrixView& a, size_t i0, size_t rows, size_t k0, size_t kc,
+                           const float* panel, size_t nc, float* c, size_t ldc) {
+            for (size_t ib = 0; ib < rows; ib += GEMM_MR) {
+                const size_t mr = std::min(GEMM_MR, rows - ib);
+                for (size_t js = 0; js < nc; js += GEMM_NR) {
+                    const size_t cols = std::min(GEMM_NR, nc - js);
+                    const float* strip = panel + js * kc;
+                    float* cRows[GEMM_MR];
+                    for (size_t r = 0; r < mr; ++r) {
+                        cRows[r] = c + (ib + r) * ldc + js;
+                    }
+
+                    if (mr == GEMM_MR) {
+                        microKernel<GEMM_MR>(a, i0 + ib, k0, kc, strip, cRows, cols);
+                    } else {
+                        for (size_t r = 0; r < mr; ++r) {
+                            microKernel<1>(a, i0 + ib + r, k0, kc, strip, cRows + r, cols);
+                        }
+                    }
                 }
-            } else {
-                bNorm[i] = b[i];
             }
         }
 
-        // Compute similarity matrix
-        std::vector<std::vector<float>> result(a.size(), std::vector<float>(b.size()));
+        // Feed scores of query rows [i0, i1) against corpus rows [m0, m1) into bounded heaps
+        // heaps holds kBest entries per query row starting at row i0, ordered by betterMatch so the worst match is in front
+        void scanTopK(const MatrixView& queries, size_t i0, size_t i1, const MatrixView& corpus, size_t m0, size_t m1,
+                      size_t kBest, ScoredIndex* heaps, size_t* heapSizes) {
+            const size_t d = queries.cols;
+
+            // Packed corpus block: all K-blocks of GEMM_NC corpus rows, one after another
+            const size_t blockColumns = paddedColumns(std::min(GEMM_NC, m1 - m0));
+            std::vector<float> panel(d * blockColumns);
+            std::vector<float> tile(TOPK_QUERY_BLOCK * GEMM_NC);
 
-        for (size_t i = 0; i < a.size(); ++i) {
-            for (size_t j = 0; j < b.size(); ++j) {
-                float dotProduct = 0.0f;
-                for (size_t k = 0; k < aNorm[i].size(); ++k) {
-                    dotProduct += aNorm[i][k] * bNorm[j][k];
+            for (size_t j0 = m0; j0 < m1; j0 += GEMM_NC) {
+                const size_t nc = std::min(GEMM_NC, m1 - j0);
+                for (size_t k0 = 0; k0 < d; k0 += GEMM_KC) {
+                    packPanel(corpus, j0, nc, k0, std::min(GEMM_KC, d - k0), panel.data() + k0 * blockColumns);
                 }
-                result[i][j] = dotProduct;
+
+                for (size_t b0 = i0; b0 < i1; b0 += TOPK_QUERY_BLOCK) {
+                    const size_t rows = std::min(TOPK_QUERY_BLOCK, i1 - b0);
+
+                    // Scores of this query block against this corpus block
+                    std::fill(tile.begin(), tile.begin() + rows * nc, 0.0f);
+                    for (size_t k0 = 0; k0 < d; k0 += GEMM_KC) {
+                        multiplyPanel(queries, b0, rows, k0, std::min(GEMM_KC, d - k0),
+                                      panel.data() + k0 * blockColumns, nc, tile.data(), nc);
+                    }
+
+                    for (size_t r = 0; r < rows; ++r) {
+                        ScoredIndex* heap = heaps + (b0 - i0 + r) * kBest;
+                        size_t& size = heapSizes[b0 - i0 + r];
+                        const float* scores = tile.data() + r * nc;
+
+                        for (size_t j = 0; j < nc; ++j) {
+                            pushBounded(heap, size, kBest, { static_cast<uint32_t>(j0 + j), scores[j] });
+                        }
+                    }
+                }
+            }
+        }
+
+    } // namespace
+
+    void setThreadCount(size_t threads) {
+        requestedThreads.store(threads, std::memory_order_relaxed);
+    }
+
+    size_t threadCount() {
+        const size_t available = utils::defaultThreadPool().concurrency();
+        const size_t requested = requestedThreads.load(std::memory_order_relaxed);
+        return requested == 0 ? available : std::min(requested, available);
+    }
+
+    void matmulTransposed(const MatrixView& a, const MatrixView& b, Matrix& c) {
+        if (a.cols != b.cols) {
+            throw std::runtime_error("Matrix dimensions must match for multiplication");
+        }
+
+        c = Matrix(a.rows, b.rows);
+        if (a.empty() || b.empty()) {
+            return;
+        }
+
+        const size_t n = a.rows;
+        const size_t m = b.rows;
+        const size_t d = a.cols;
+
+        // c[i0:i1, j0:j1) = a[i0:i1] * b[j0:j1]^T, with its own packed panel
+        auto multiplyBlock = [&](size_t i0, size_t i1, size_t jBegin, size_t jEnd) {
+            std::vector<float> panel(std::min(GEMM_KC, d) * paddedColumns(std::min(GEMM_NC, jEnd - jBegin)));
+            for (size_t j0 = jBegin; j0 < jEnd; j0 += GEMM_NC) {
+                const size_t nc = std::min(GEMM_NC, jEnd - j0);
+                for (size_t k0 = 0; k0 < d; k0 += GEMM_KC) {
+                    const size_t kc = std::min(GEMM_KC, d - k0);
+                    packPanel(b, j0, nc, k0, kc, panel.data());
+
+                    // Stream rows of a through the packed panel
+                    multiplyPanel(a, i0, i1 - i0, k0, kc, panel.data(), nc, c.row(i0) + j0, m);
+                }
+            }
+        };
+
+        // Tall a: shard by row tiles, every thread packs all of b. Otherwise shard b by column panels
+        const size_t work = n * m * d;
+        if (ceilDiv(n, GEMM_MR) >= ceilDiv(m, GEMM_NC)) {
+            parallelShards(ceilDiv(n, GEMM_MR), work, [&](size_t begin, size_t end) {
+                multiplyBlock(begin * GEMM_MR, std::min(n, end * GEMM_MR), 0, m);
+            });
+        } else {
+            parallelShards(ceilDiv(m, GEMM_NC), work, [&](size_t begin, size_t end) {
+                multiplyBlock(0, n, begin * GEMM_NC, std::min(m, end * GEMM_NC));
+            });
+        }
+    }
+
+    TopK topKDotProduct(const MatrixView& queries, const MatrixView& corpus, size_t k) {
+        if (queries.cols != corpus.cols) {
+            throw std::runtime_error("Matrix dimensions must match for similarity");
+        }
+
+        TopK result;
+        result.rows = queries.rows;
+        result.k = std::min(k, corpus.rows);
+        result.entries.resize(result.rows * result.k);
+        if (result.k == 0 || queries.cols == 0) {
+            return result;
+        }
+
+        const size_t n = queries.rows;
+        const size_t m = corpus.rows;
+        const size_t d = queries.cols;
+        const size_t kBest = result.k;
+        const size_t work = n * m * d;
+
+        if (ceilDiv(n, TOPK_QUERY_BLOCK) >= std::min(threadCount(), ceilDiv(m, GEMM_NC))) {
+            // Enough queries: each thread owns a range of query rows and their heaps, nothing to merge
+            std::vector<size_t> heapSizes(n, 0);
+            parallelShards(ceilDiv(n, TOPK_QUERY_BLOCK), work, [&](size_t begin, size_t end) {
+                const size_t i0 = begin * TOPK_QUERY_BLOCK;
+                const size_t i1 = std::min(n, end * TOPK_QUERY_BLOCK);
+                scanTopK(queries, i0, i1, corpus, 0, m, kBest, result.entries.data() + i0 * kBest, heapSizes.data() + i0);
+                for (size_t i = i0; i < i1; ++i) {
+                    ScoredIndex* heap = result.entries.data() + i * kBest;
+                    std::sort_heap(heap, heap + heapSizes[i], betterMatch);
+                }
+            });
+            return result;
+        }
+
+        // Few queries, large corpus: each thread scans a corpus shard into its own heaps, merged below
+        // betterMatch is a strict total order, so the merged rows do not depend on the sharding
+        const size_t panels = ceilDiv(m, GEMM_NC);
+        const size_t shards = work < PARALLEL_MIN_WORK ? 1 : std::min(panels, threadCount());
+        const size_t panelsPerShard = ceilDiv(panels, shards);
+        std::vector<std::vector<ScoredIndex>> shardHeaps(ceilDiv(panels, panelsPerShard));
+        std::vector<std::vector<size_t>> shardSizes(shardHeaps.size());
+
+        parallelShards(panels, work, [&](size_t begin, size_t end) {
+            const size_t shard = begin / panelsPerShard;
+            shardHeaps[shard].resize(n * kBest);
+            shardSizes[shard].assign(n, 0);
+            scanTopK(queries, 0, n, corpus, begin * GEMM_NC, std::min(m, end * GEMM_NC), kBest,
+                     shardHeaps[shard].data(), shardSizes[shard].data());
+        });
+
+        std::vector<ScoredIndex> merged;
+        for (size_t i = 0; i < n; ++i) {
+            merged.clear();
+            for (size_t shard = 0; shard < shardHeaps.size(); ++shard) {
+                const ScoredIndex* heap = shardHeaps[shard].data() + i * kBest;
+                merged.insert(merged.end(), heap, heap + shardSizes[shard][i]);
             }
+            std::partial_sort(merged.begin(), merged.begin() + kBest, merged.end(), betterMatch);
+            std::copy(merged.begin(), merged.begin() + kBest, result.entries.begin() + i * kBest);
         }
 
         return result;
     }
 
-} // namespace math
+    TopK topKSimilarity(const MatrixView& queries, const MatrixView& corpus, size_t k) {
+        // Normalize all vectors once
+        Matrix queriesNorm = Matrix::fromView(queries);
+        Matrix corpusNorm = Matrix::fromView(corpus);
+        normalizeRows(queriesNorm);
+        normalizeRows(corpusNorm);
+        return topKDotProduct(queriesNorm, corpusNorm, k);
+    }
 
+    Matrix cosineSimilarityMatrix(const MatrixView& a, const MatrixView& b) {
+        if (a.empty() || b.empty()) {
+            return Matrix();
+        }
+
+        // Normalize all vectors once
+        Matrix aNorm = Matrix::fromView(a);
+        Matrix bNorm = Matrix::fromView(b);
+        normalizeRows(aNorm);
+        normalizeRows(bNorm);
+
+        // Compute similarity matrix
+        return dotProductMatrix(aNorm, bNorm);
+    }
+
+    Matrix dotProductMatrix(const MatrixView& a, const MatrixView& b) {
+        Matrix result;
+        matmulTransposed(a, b, result);
+        return result;
+    }
+
+} // namespace math
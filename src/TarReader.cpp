@@ -0,0 +1,204 @@
+#include "../include/utils/TarReader.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace utils {
+
+    namespace {
+
+        constexpr size_t BLOCK_SIZE = 512;
+        constexpr size_t STREAM_BUFFER_SIZE = 1 << 20;
+
+        // Long names and pax records are a few hundred bytes; a larger one is a corrupt header
+        constexpr uint64_t MAX_HEADER_RECORD_SIZE = 1 << 20;
+
+        // ustar header field offsets and sizes
+        constexpr size_t NAME_OFFSET = 0, NAME_SIZE = 100;
+        constexpr size_t SIZE_OFFSET = 124, SIZE_SIZE = 12;
+        constexpr size_t CHECKSUM_OFFSET = 148, CHECKSUM_SIZE = 8;
+        constexpr size_t TYPE_OFFSET = 156;
+        constexpr size_t MAGIC_OFFSET = 257;
+        constexpr size_t PREFIX_OFFSET = 345, PREFIX_SIZE = 155;
+
+        uint64_t paddedSize(uint64_t size) {
+            return (size + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+        }
+
+        // NUL-terminated or full-width string field
+        std::string field(const char* header, size_t offset, size_t size) {
+            const char* begin = header + offset;
+            return std::string(begin, std::find(begin, begin + size, '\0'));
+        }
+
+        // Octal number, or GNU base-256 when the high bit of the first byte is set
+        uint64_t numberField(const char* header, size_t offset, size_t size) {
+            const unsigned char* p = reinterpret_cast<const unsigned char*>(header + offset);
+            uint64_t value = 0;
+            if (p[0] & 0x80) {
+                value = p[0] & 0x7F;
+                for (size_t i = 1; i < size; ++i) {
+                    value = (value << 8) | p[i];
+                }
+                return value;
+            }
+            for (size_t i = 0; i < size && p[i] != '\0' && p[i] != ' '; ++i) {
+                if (p[i] < '0' || p[i] > '7') {
+                    throw std::runtime_error("Invalid number in tar header");
+                }
+                value = (value << 3) | static_cast<uint64_t>(p[i] - '0');
+            }
+            return value;
+        }
+
+        bool checksumValid(const char* header) {
+            // Sum of all header bytes with the checksum field counted as spaces
+            uint64_t sum = 0;
+            for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+                bool inChecksum = i >= CHECKSUM_OFFSET && i < CHECKSUM_OFFSET + CHECKSUM_SIZE;
+                sum += inChecksum ? static_cast<unsigned char>(' ') : static_cast<unsigned char>(header[i]);
+            }
+            // Leading spaces are allowed by some writers
+            size_t start = CHECKSUM_OFFSET;
+            while (start < CHECKSUM_OFFSET + CHECKSUM_SIZE && header[start] == ' ') {
+                ++start;
+            }
+            return numberField(header, start, CHECKSUM_OFFSET + CHECKSUM_SIZE - start) == sum;
+        }
+
+        // "path" value of pax extended header records: "<length> <key>=<value>\n"
+        std::string paxPath(const std::string& records) {
+            std::string path;
+            size_t pos = 0;
+            while (pos < records.size()) {
+                size_t space = records.find(' ', pos);
+                if (space == std::string::npos) {
+                    break;
+                }
+                size_t length = std::stoul(records.substr(pos, space - pos));
+                if (length == 0 || pos + length > records.size()) {
+                    break;
+                }
+                std::string record = records.substr(space + 1, pos + length - space - 2);
+                if (record.compare(0, 5, "path=") == 0) {
+                    path = record.substr(5);
+                }
+                pos += length;
+            }
+            return path;
+        }
+
+    } // namespace
+
+    TarReader::TarReader(const std::filesystem::path& tarPath)
+        : path_(tarPath), streamBuffer_(STREAM_BUFFER_SIZE), fileSize_(0), size_(0), remaining_(0) {
+        stream_.rdbuf()->pubsetbuf(streamBuffer_.data(), static_cast<std::streamsize>(streamBuffer_.size()));
+        stream_.open(tarPath, std::ios::binary);
+        if (!stream_.is_open()) {
+            throw std::runtime_error("Failed to open tar archive: " + tarPath.string());
+        }
+        fileSize_ = std::filesystem::file_size(tarPath);
+    }
+
+    bool TarReader::nextMember() {
+        skipRemainder();
+
+        std::string longName;
+        char header[BLOCK_SIZE];
+        while (true) {
+            stream_.read(header, BLOCK_SIZE);
+            if (stream_.gcount() == 0) {
+                return false;       // archive without end-of-archive blocks
+            }
+            if (static_cast<size_t>(stream_.gcount()) != BLOCK_SIZE) {
+                throw std::runtime_error("Truncated tar archive: " + path_.string());
+            }
+
+            // A zero block marks the end of the archive
+            if (std::all_of(header, header + BLOCK_SIZE, [](char c) { return c == '\0'; })) {
+                return false;
+            }
+            if (!checksumValid(header)) {
+                throw std::runtime_error("Corrupted tar header in " + path_.string());
+            }
+
+            const uint64_t size = numberField(header, SIZE_OFFSET, SIZE_SIZE);
+            const char type = header[TYPE_OFFSET];
+
+            // Check sizes against the file before callers reserve or allocate for them
+            if (size > bytesLeft()) {
+                throw std::runtime_error("Tar member larger than the rest of " + path_.string());
+            }
+
+            // GNU long name and pax extended headers describe the member that follows
+            if (type == 'L' || type == 'x') {
+                if (size > MAX_HEADER_RECORD_SIZE) {
+                    throw std::runtime_error("Oversized tar name record in " + path_.string());
+                }
+                std::string data(size, '\0');
+                readExact(&data[0], data.size());
+                stream_.ignore(static_cast<std::streamsize>(paddedSize(size) - size));
+                if (type == 'L') {
+                    longName = data.substr(0, data.find('\0'));
+                } else if (std::string path = paxPath(data); !path.empty()) {
+                    longName = path;
+                }
+                continue;
+            }
+
+            remaining_ = paddedSize(size);
+            if (type != '0' && type != '\0' && type != '7') {
+                // Directories, links, global pax headers and the like carry no image
+                skipRemainder();
+                longName.clear();
+                continue;
+            }
+
+            if (!longName.empty()) {
+                name_ = std::move(longName);
+            } else {
+                name_ = field(header, NAME_OFFSET, NAME_SIZE);
+                if (std::memcmp(header + MAGIC_OFFSET, "ustar", 5) == 0) {
+                    std::string prefix = field(header, PREFIX_OFFSET, PREFIX_SIZE);
+                    if (!prefix.empty()) {
+                        name_ = prefix + "/" + name_;
+                    }
+                }
+            }
+            size_ = size;
+            return true;
+        }
+    }
+
+    void TarReader::read(std::vector<uint8_t>& out) {
+        if (remaining_ != paddedSize(size_)) {
+            throw std::runtime_error("Tar member was already read: " + name_);
+        }
+        out.resize(static_cast<size_t>(size_));
+        readExact(reinterpret_cast<char*>(out.data()), out.size());
+        remaining_ -= size_;
+    }
+
+    void TarReader::skipRemainder() {
+        if (remaining_ > 0) {
+            stream_.ignore(static_cast<std::streamsize>(remaining_));
+            remaining_ = 0;
+        }
+    }
+
+    uint64_t TarReader::bytesLeft() {
+        const std::streamoff position = stream_.tellg();
+        if (position < 0) {
+            throw std::runtime_error("Failed to read tar archive: " + path_.string());
+        }
+        return fileSize_ - std::min(fileSize_, static_cast<uint64_t>(position));
+    }
+
+    void TarReader::readExact(char* out, size_t size) {
+        stream_.read(out, static_cast<std::streamsize>(size));
+        if (static_cast<size_t>(stream_.gcount()) != size) {
+            throw std::runtime_error("Truncated tar archive: " + path_.string());
+        }
+    }
+
+} // namespace utils
@@ -0,0 +1,187 @@
+#include "../include/pipeline/TarShardReader.h"
+#include "../include/utils/BufferPool.h"
+#include "../include/utils/FileUtils.h"
+#include "../include/utils/TarReader.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace pipeline {
+
+    namespace {
+
+        bool isTarFile(const std::filesystem::path& path) {
+            return utils::equalsIgnoreCase(path.extension().native(), ".tar");
+        }
+
+    } // namespace
+
+    TarShardReader::TarShardReader(std::vector<std::filesystem::path> shards, const TarShardOptions& options)
+        : shards_(std::move(shards)),
+          options_(options),
+          nextShard_(0),
+          bytesInFlight_(0),
+          activeReaders_(0),
+          stopping_(false) {
+        options_.threads = std::max(1, std::min(options_.threads, static_cast<int>(shards_.size())));
+        if (shards_.empty() || options_.limit == 0) {
+            return;
+        }
+
+        activeReaders_ = options_.threads;
+        readers_.reserve(static_cast<size_t>(options_.threads));
+        for (int i = 0; i < options_.threads; ++i) {
+            readers_.emplace_back(&TarShardReader::readerLoop, this);
+        }
+    }
+
+    TarShardReader::~TarShardReader() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        budgetFreed_.notify_all();
+        for (auto& reader : readers_) {
+            reader.join();
+        }
+        for (auto& image : ready_) {
+            utils::byteBufferPool().release(std::move(image.data));
+        }
+    }
+
+    std::optional<EncodedImage> TarShardReader::next() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        imageReady_.wait(lock, [this] { return !ready_.empty() || activeReaders_ == 0; });
+        if (ready_.empty()) {
+            return std::nullopt;
+        }
+
+        EncodedImage image = std::move(ready_.front());
+        ready_.pop_front();
+        bytesInFlight_ -= image.data.capacity();
+        budgetFreed_.notify_all();
+        return image;
+    }
+
+    std::string TarShardReader::key(size_t index) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return keys_.at(index);
+    }
+
+    bool TarShardReader::publish(std::string key, std::vector<uint8_t> data, std::string error) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (stopping_ || keys_.size() >= options_.limit) {
+            bytesInFlight_ -= data.capacity();
+            budgetFreed_.notify_all();
+            utils::byteBufferPool().release(std::move(data));
+            return false;
+        }
+
+        ready_.push_back({ keys_.size(), std::move(data), std::move(error) });
+        keys_.push_back(std::move(key));
+        imageReady_.notify_one();
+        return keys_.size() < options_.limit;
+    }
+
+    void TarShardReader::readerLoop() {
+        while (true) {
+            const size_t shardIndex = nextShard_.fetch_add(1);
+            if (shardIndex >= shards_.size()) {
+                break;
+            }
+            const std::filesystem::path& shardPath = shards_[shardIndex];
+            const std::string shardName = shardPath.filename().string();
+
+            bool keepGoing = true;
+            try {
+                utils::TarReader tar(shardPath);
+                while (keepGoing && tar.nextMember()) {
+                    const utils::ImageFormat byName = utils::imageFormatFromName(tar.name());
+                    const bool sniff = byName == utils::ImageFormat::Unknown;
+                    if (sniff ? !options_.sniffContent : !utils::isDecodableImageFormat(byName)) {
+                        continue;
+                    }
+
+                    // Wait until the decoders caught up and reserve the member under the same lock, so
+                    // concurrent readers cannot all pass the check; an oversized member goes through alone.
+                    // nextMember() already rejected sizes beyond the end of the shard
+                    size_t reserved = static_cast<size_t>(tar.size());
+                    {
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        budgetFreed_.wait(lock, [&] {
+                            return stopping_ || bytesInFlight_ == 0 || bytesInFlight_ + reserved <= options_.maxBytesInFlight;
+                        });
+                        if (stopping_) {
+                            keepGoing = false;
+                            break;
+                        }
+                        bytesInFlight_ += reserved;
+                    }
+
+                    // The budget counts buffer capacity, which for a recycled buffer exceeds the member size
+                    std::vector<uint8_t> data;
+                    try {
+                        data = utils::byteBufferPool().acquire(reserved);
+                        {
+                            std::lock_guard<std::mutex> lock(mutex_);
+                            bytesInFlight_ += data.capacity() - reserved;
+                            reserved = data.capacity();
+                        }
+                        tar.read(data);
+                        if (sniff && !utils::isDecodableImageFormat(utils::sniffImageFormat(data.data(), data.size()))) {
+                            {
+                                std::lock_guard<std::mutex> lock(mutex_);
+                                bytesInFlight_ -= reserved;
+                            }
+                            budgetFreed_.notify_all();
+                            utils::byteBufferPool().release(std::move(data));
+                            continue;
+                        }
+                    } catch (...) {
+                        {
+                            std::lock_guard<std::mutex> lock(mutex_);
+                            bytesInFlight_ -= reserved;
+                        }
+                        budgetFreed_.notify_all();
+                        utils::byteBufferPool().release(std::move(data));
+                        throw;
+                    }
+                    keepGoing = publish(shardName + "/" + tar.name(), std::move(data), {});
+                }
+            } catch (const std::exception& e) {
+                keepGoing = publish(shardName, {}, e.what());
+            }
+
+            if (!keepGoing) {
+                break;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--activeReaders_ == 0) {
+            imageReady_.notify_all();
+        }
+    }
+
+    std::vector<std::filesystem::path> findTarShards(const std::filesystem::path& path) {
+        if (!std::filesystem::exists(path)) {
+            throw std::runtime_error("Shard path not found: " + path.string());
+        }
+        if (!std::filesystem::is_directory(path)) {
+            return { path };
+        }
+
+        std::vector<std::filesystem::path> shards;
+        for (const auto& entry : std::filesystem::directory_iterator(path)) {
+            if (entry.is_regular_file() && isTarFile(entry.path())) {
+                shards.push_back(entry.path());
+            }
+        }
+        std::sort(shards.begin(), shards.end());
+
+        if (shards.empty()) {
+            throw std::runtime_error("No tar shards found in: " + path.string());
+        }
+        return shards;
+    }
+
+} // namespace pipeline
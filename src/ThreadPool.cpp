@@ -0,0 +1,121 @@
+#include "../include/utils/ThreadPool.h"
+
+namespace utils {
+
+    namespace {
+
+        // Set on pool workers, and on the caller while it runs tasks, to turn nested parallelFor into a plain loop
+        thread_local bool insideTask = false;
+
+    } // namespace
+
+    ThreadPool::ThreadPool(size_t workers)
+        : task_(nullptr),
+          taskCount_(0),
+          nextTask_(0),
+          pendingTasks_(0),
+          generation_(0),
+          stopping_(false) {
+        if (workers == 0) {
+            unsigned int hw = std::thread::hardware_concurrency();
+            workers = hw > 1 ? hw - 1 : 0;
+        }
+
+        workers_.reserve(workers);
+        for (size_t i = 0; i < workers; ++i) {
+            workers_.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        jobReady_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::parallelFor(size_t tasks, const std::function<void(size_t)>& task) {
+        if (tasks == 0) {
+            return;
+        }
+        if (tasks == 1 || workers_.empty() || insideTask) {
+            for (size_t i = 0; i < tasks; ++i) {
+                task(i);
+            }
+            return;
+        }
+
+        std::lock_guard<std::mutex> submitLock(submitMutex_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            task_ = &task;
+            taskCount_ = tasks;
+            nextTask_ = 0;
+            pendingTasks_ = tasks;
+            error_ = nullptr;
+            ++generation_;
+        }
+        jobReady_.notify_all();
+
+        insideTask = true;
+        runTasks();
+        insideTask = false;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        jobDone_.wait(lock, [this] { return pendingTasks_ == 0; });
+        task_ = nullptr;
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+    }
+
+    void ThreadPool::runTasks() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (nextTask_ < taskCount_) {
+            const size_t index = nextTask_++;
+            const auto* task = task_;
+            lock.unlock();
+
+            std::exception_ptr error;
+            try {
+                (*task)(index);
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            lock.lock();
+            if (error && !error_) {
+                error_ = error;
+            }
+            if (--pendingTasks_ == 0) {
+                jobDone_.notify_all();
+            }
+        }
+    }
+
+    void ThreadPool::workerLoop() {
+        insideTask = true;
+        uint64_t seenGeneration = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                jobReady_.wait(lock, [&] { return stopping_ || generation_ != seenGeneration; });
+                if (stopping_) {
+                    return;
+                }
+                seenGeneration = generation_;
+            }
+            runTasks();
+        }
+    }
+
+    ThreadPool& defaultThreadPool() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+} // namespace utils
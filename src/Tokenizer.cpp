@@ -1,5 +1,6 @@
 #include "../include/text/Tokenizer.h"
 #include "../include/config/Config.h"
+#include "../include/utils/BufferPool.h"
 #include <algorithm>
 #include <stdexcept>
 
@@ -27,23 +28,14 @@ namespace text {
         // Get BPE tokens
         std::vector<int32_t> tokens = bpeTokenizer_->tokenize(text);
 
-        // Add special tokens: [SOT] + tokens + [EOT]
-        std::vector<int32_t> result;
-        result.reserve(config::CONTEXT_LENGTH);
-        result.push_back(config::TOKEN_START_OF_TEXT);
-        result.insert(result.end(), tokens.begin(), tokens.end());
-        result.push_back(config::TOKEN_END_OF_TEXT);
-
-        // Truncate if too long
-        if (result.size() > static_cast<size_t>(config::CONTEXT_LENGTH)) {
-            result.resize(config::CONTEXT_LENGTH);
-            result[config::CONTEXT_LENGTH - 1] = config::TOKEN_END_OF_TEXT;
-        }
-
-        // Pad to context length
-        while (result.size() < static_cast<size_t>(config::CONTEXT_LENGTH)) {
-            result.push_back(config::TOKEN_PAD);
-        }
+        // [SOT] + tokens + [EOT] padded to context length; long texts are truncated with [EOT] kept last
+        const size_t contextLength = static_cast<size_t>(config::CONTEXT_LENGTH);
+        const size_t count = std::min(tokens.size(), contextLength - 2);
+        std::vector<int32_t> result = utils::tokenBufferPool().acquire(contextLength);
+        result[0] = config::TOKEN_START_OF_TEXT;
+        std::copy_n(tokens.begin(), count, result.begin() + 1);
+        result[count + 1] = config::TOKEN_END_OF_TEXT;
+        std::fill(result.begin() + static_cast<std::ptrdiff_t>(count + 2), result.end(), config::TOKEN_PAD);
 
         return result;
     }
@@ -0,0 +1,93 @@
+"""Prepend uint8 -> float normalization to image_encoder.onnx.
+
+The resulting model takes raw RGB uint8 pixels, so the C++ side only resizes
+and copies bytes (ImageProcessor::preprocessImageUint8). CLIPInference detects
+the uint8 input automatically.
+
+    python tools/fold_image_normalization.py models/image_encoder.onnx models/image_encoder_uint8.onnx
+    python tools/fold_image_normalization.py in.onnx out.onnx --layout nhwc
+
+Requires the onnx package (pip install onnx).
+"""
+
+import argparse
+
+import numpy as np
+import onnx
+from onnx import TensorProto, helper, numpy_helper
+
+# Must match include/config/Config.h
+IMAGE_MEAN = [0.485, 0.456, 0.406]
+IMAGE_STD = [0.229, 0.224, 0.225]
+
+
+def fold_normalization(model, layout):
+    graph = model.graph
+    if len(graph.input) != 1:
+        raise ValueError("Expected image encoder with a single input, got %d" % len(graph.input))
+
+    old_input = graph.input[0]
+    if old_input.type.tensor_type.elem_type != TensorProto.FLOAT:
+        raise ValueError("Input '%s' is not float32, model already converted?" % old_input.name)
+
+    dims = old_input.type.tensor_type.shape.dim
+    if len(dims) != 4:
+        raise ValueError("Expected 4D NCHW input, got %dD" % len(dims))
+
+    input_name = old_input.name
+    normalized_name = input_name + "_normalized"
+
+    # Original consumers now read the normalized float tensor
+    for node in graph.node:
+        for i, name in enumerate(node.input):
+            if name == input_name:
+                node.input[i] = normalized_name
+
+    # (x / 255 - mean) / std == x * scale + bias
+    scale = np.array([1.0 / (255.0 * s) for s in IMAGE_STD], dtype=np.float32).reshape(1, 3, 1, 1)
+    bias = np.array([-m / s for m, s in zip(IMAGE_MEAN, IMAGE_STD)], dtype=np.float32).reshape(1, 3, 1, 1)
+    graph.initializer.extend([
+        numpy_helper.from_array(scale, input_name + "_scale"),
+        numpy_helper.from_array(bias, input_name + "_bias"),
+    ])
+
+    nodes = []
+    cast_input = input_name
+    if layout == "nhwc":
+        nodes.append(helper.make_node("Transpose", [input_name], [input_name + "_nchw"], perm=[0, 3, 1, 2]))
+        cast_input = input_name + "_nchw"
+    nodes.append(helper.make_node("Cast", [cast_input], [input_name + "_float"], to=TensorProto.FLOAT))
+    nodes.append(helper.make_node("Mul", [input_name + "_float", input_name + "_scale"], [input_name + "_scaled"]))
+    nodes.append(helper.make_node("Add", [input_name + "_scaled", input_name + "_bias"], [normalized_name]))
+
+    # Keep batch dimension as in the original model (fixed or symbolic)
+    batch_dim = dims[0].dim_param or dims[0].dim_value or "batch"
+    channels, height, width = (d.dim_value for d in dims[1:])
+    shape = [batch_dim, channels, height, width] if layout == "nchw" else [batch_dim, height, width, channels]
+    new_input = helper.make_tensor_value_info(input_name, TensorProto.UINT8, shape)
+
+    graph.input.remove(old_input)
+    graph.input.insert(0, new_input)
+
+    existing = list(graph.node)
+    del graph.node[:]
+    graph.node.extend(nodes + existing)
+    return model
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Fold image normalization into image_encoder.onnx")
+    parser.add_argument("input", help="Path to float32 image_encoder.onnx")
+    parser.add_argument("output", help="Path to write uint8 model")
+    parser.add_argument("--layout", choices=["nchw", "nhwc"], default="nchw", help="Layout of the uint8 input")
+    args = parser.parse_args()
+
+    model = onnx.load(args.input)
+    model = fold_normalization(model, args.layout)
+    onnx.checker.check_model(model)
+    onnx.save(model, args.output)
+    print("Saved %s (uint8 %s input)" % (args.output, args.layout.upper()))
+
+
+if __name__ == "__main__":
+    main()